@@ -16,13 +16,29 @@
 #include "boilr.h"
 #include "registerBuilds.h"  // This registers all builds automatically
 #include "buildRegistry.h"
+#include "buildDelta.h"
+#include "durability.h"
+#include "gitInit.h"
+#include "progress.h"
+#include <cerrno>
+#include <chrono>
 #include <climits>
 #include <cstring>
 #include <iostream>
 #include <fstream>
+#include <iterator>
 #include <filesystem>
 #include <memory>
+#include <random>
 #include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
 
 #define BR boilr
 namespace fs =  std::filesystem;
@@ -46,6 +62,48 @@ namespace {
     const char* COLOR_GREEN = "\033[32m";
     const char* COLOR_RED = "\033[91m";
     const char* COLOR_RESET = "\033[0m";
+
+    // pause between reads of the extractor's listing (see BR::unzip)
+    const std::chrono::milliseconds PIPE_BATCH_DELAY(2);
+
+    // entry name from an "  inflating: dest/name" (unzip) or "x name" (tar) line
+    string extracted_entry(const string& line, const string& prefix)
+    {
+        string name;
+        if (line.compare(0, 2, "x ") == 0)
+        {
+            name = line.substr(2);
+        }
+        else
+        {
+            size_t colon = line.find(": ");
+            if (colon == string::npos) { return ""; }
+            string action = line.substr(0, colon);
+            action.erase(0, action.find_first_not_of(' '));
+            if (action != "inflating" && action != "extracting" && action != "creating" && action != "linking")
+            {
+                return "";
+            }
+            name = line.substr(colon + 2);
+            size_t arrow = name.find("  -> ");
+            if (arrow != string::npos) { name.erase(arrow); }
+        }
+        name.erase(name.find_last_not_of(" \r\n") + 1);
+        if (name.compare(0, prefix.size(), prefix) == 0) { name.erase(0, prefix.size()); }
+        return name;
+    }
+
+    // extractor messages kept by BR::unzip while it reads the listing
+    const size_t MAX_EXTRACT_MESSAGES = 20;
+
+    void keep_message(vector<string>& messages, string line)
+    {
+        line.erase(line.find_last_not_of(" \r\n") + 1);
+        // unzip's banner naming the archive is not a message
+        if (line.empty() || line.compare(0, 8, "Archive:") == 0) { return; }
+        if (messages.size() == MAX_EXTRACT_MESSAGES) { messages.erase(messages.begin()); }
+        messages.push_back(line);
+    }
 }
 
 
@@ -115,13 +173,39 @@ OPTIONS:
     
     -I, -ID <id>           Specify the template ID to use
     
-    -TN, -TNAME <name>     Specify the template name to use
+    -TN, -TNAME <name>     Specify the template name to use, optionally
+                            tagged with a version (name@version)
     
     -N, -NAME <name>       Set the project name (default: boilr-template)
     
     -D, -DESTINATION <path> Set the destination directory for the project
                             (default: current directory)
 
+    -G, --git              Create a git repository with an initial commit
+                            of the generated project. Runs after extraction
+                            and reads every file back, like git add -A.
+                            Author and committer come from GIT_AUTHOR_* /
+                            GIT_COMMITTER_*, then user.name and user.email
+                            in ~/.gitconfig, $XDG_CONFIG_HOME/git/config or
+                            $GIT_CONFIG_GLOBAL; fails if none is set. The
+                            branch is init.defaultBranch (default master),
+                            the date carries the local UTC offset
+
+    --progress=<mode>      Live progress while extracting: auto (default,
+                            only on a terminal), tty, json or none. json
+                            prints one object per line on stderr. Counts
+                            come from the extractor's per-entry listing, so
+                            entries it renames or escapes show 0 bytes
+
+    --sync <policy>        Durability of the written project: none (default,
+                            no syncs), batch (one filesystem sync and a
+                            directory fsync) or strict (fsync every file and
+                            directory before the project is moved into place)
+
+    -MD, -MAKE-DELTA <base.zip> <target.zip> <out.delta>
+                            Encode a template version as a delta against its
+                            base zip, for use with REGISTER_BUILD_DELTA
+
 EXAMPLES:
     boilr -h
         Show this help message
@@ -136,6 +220,12 @@ EXAMPLES:
         Create a project using template named "my-template" with name "my-app"
         in ~/workspace directory
 
+    boilr -I 0 -N my-app --git
+        Create a project and commit it to a new git repository
+
+    boilr -TN spring-boot@3 -N my-api
+        Create a project from version 3 of the "spring-boot" template
+
 NOTES:
     For convenience, add this tool to your system PATH so you can run it from
     anywhere without specifying the full path.
@@ -224,7 +314,15 @@ bool BR::verify_id(map<unsigned int, build>& builds, const int id)
 }
 int BR::verify_template_name(map<unsigned int, build>& builds, const string name)
 {
-    // checks each pair
+    // checks each pair for an exact name@version match
+    for (auto& pair : builds)
+    {
+        if (build_tag(pair.second) == name)
+        {
+            return pair.first;
+        }
+    }
+    // untagged name falls back to the first build registered under it
     for (auto& pair : builds)
     {
         if (pair.second.name == name)
@@ -252,58 +350,96 @@ bool BR::insert(build* b)
     {
         return false;
     }
-    // reconstruct byte .h file into destination
-    if (!write_zip(b))
+    // every run works in its own staging folder inside the destination,
+    // so concurrent scaffolds into the same place never see each other
+    fs::path dest_dir       = fs::path(config.project_destination);
+    fs::path project_folder = dest_dir / config.project_name;
+    fs::path staging        = staging_dir(dest_dir, config.project_name);
+    fs::path zip_path       = staging / (config.project_name + ".zip");
+    fs::path extract_dir    = staging / "extract";
+
+    // reconstruct byte .h file into the staging folder
+    if (!write_zip(b, zip_path))
     {
+        clean_up(staging);
         return false;
     }
     // unzip ZIP file
-    fs::path dest_dir = fs::path(config.project_destination);
-    fs::path zip_path = dest_dir / (config.project_name + ".zip");
-    
-    // Get list of directories before extraction to find what was extracted
-    std::set<fs::path> dirs_before;
-    if (fs::exists(dest_dir) && fs::is_directory(dest_dir))
-    {
-        for (const auto& entry : fs::directory_iterator(dest_dir))
-        {
-            if (fs::is_directory(entry.path()))
-            {
-                dirs_before.insert(entry.path());
-            }
-        }
-    }
-    
-    if (!this->unzip(zip_path, dest_dir))
+    progress_reporter progress(config.progress_mode);
+    if (!this->unzip(zip_path, extract_dir, &progress))
     {
         cout << "[PROC]Extracting Template... " << COLOR_RED << "FAIL" << COLOR_RESET << "\n";
+        clean_up(staging);
         return false;
     }
     cout << "[PROC]Extracting Template... " << COLOR_GREEN << "OK" << COLOR_RESET << "\n";
-    
-    // Find the newly extracted folder and rename it to project name
-    fs::path extracted_folder;
-    for (const auto& entry : fs::directory_iterator(dest_dir))
+
+    // the template's single top-level folder becomes the project,
+    // a template zipped without one is used as a whole
+    fs::path extracted_folder = extract_dir;
+    vector<fs::directory_entry> top_level(fs::directory_iterator(extract_dir), fs::directory_iterator{});
+    if (top_level.size() == 1 && top_level[0].is_directory())
+    {
+        extracted_folder = top_level[0].path();
+    }
+
+    // Create the repository before the folder is moved into place
+    if (config.git_init)
     {
-        if (fs::is_directory(entry.path()) && dirs_before.find(entry.path()) == dirs_before.end())
+        string error;
+        if (!git_init_repository(extracted_folder, error, &progress))
         {
-            extracted_folder = entry.path();
-            break;
+            cout << "[ERROR] " << error << endl;
+            cout << "[PROC]Initializing Git Repository... " << COLOR_RED << "FAIL" << COLOR_RESET << "\n";
+            clean_up(staging);
+            return false;
         }
+        cout << "[PROC]Initializing Git Repository... " << COLOR_GREEN << "OK" << COLOR_RESET << "\n";
     }
-    
+
+    // Make the project durable before it appears under its final name
+    string sync_error;
+    if (!sync_tree(extracted_folder, config.sync_policy, sync_error))
+    {
+        cout << "[ERROR] " << sync_error << endl;
+        cout << "[PROC]Syncing Project... " << COLOR_RED << "FAIL" << COLOR_RESET << "\n";
+        clean_up(staging);
+        return false;
+    }
+
     // Rename extracted folder to project name
-    if (!extracted_folder.empty())
+    try
     {
-        fs::path project_folder = dest_dir / config.project_name;
         if (fs::exists(project_folder))
         {
             fs::remove_all(project_folder);
         }
         fs::rename(extracted_folder, project_folder);
     }
-    
-    if (!clean_up(zip_path))
+    catch (const fs::filesystem_error& e)
+    {
+        cout << "[ERROR] " << e.what() << endl;
+        cout << "[PROC]Moving Project... " << COLOR_RED << "FAIL" << COLOR_RESET << "\n";
+        clean_up(staging);
+        return false;
+    }
+    if (config.sync_policy != "none")
+    {
+        // persists the rename itself; the project is already in place,
+        // so a failure here only means the rename may not survive a crash
+        if (sync_directory(dest_dir, sync_error))
+        {
+            cout << "[PROC]Syncing Project (" << config.sync_policy << ")... " << COLOR_GREEN << "OK" << COLOR_RESET << "\n";
+        }
+        else
+        {
+            cout << "[WARNING] " << project_folder.string() << " was created, but syncing "
+                 << sync_error << " failed; the project may not survive a crash" << endl;
+            cout << "[PROC]Syncing Project (" << config.sync_policy << ")... " << COLOR_RED << "WARN" << COLOR_RESET << "\n";
+        }
+    }
+
+    if (!clean_up(staging))
     {
         cout << "[PROC]Removing ZIP... " << COLOR_RED << "FAIL" << COLOR_RESET << "\n";
         return false;
@@ -312,18 +448,20 @@ bool BR::insert(build* b)
     return true;
 }
 
-
-bool BR::write_zip(build* b)
+// hidden, uniquely named folder next to where the project will land
+fs::path BR::staging_dir(const fs::path& dest_dir, const string& project_name)
 {
-    const USER_CONFIG config = this->user_config;
-    // Explicit destination directory
-    fs::path dest_dir = fs::path(config.project_destination);
+    std::random_device rd;
+    std::ostringstream name;
+    name << "." << project_name << ".boilr-staging-" << std::hex << rd() << rd();
+    return dest_dir / name.str();
+}
 
-    // Explicit zip file path
-    fs::path zip_path = dest_dir / (config.project_name + ".zip");
 
-    // Ensure destination directory exists
-    fs::create_directories(config.project_destination);
+bool BR::write_zip(build* b, const fs::path& zip_path)
+{
+    // Ensure the folder holding the zip exists
+    fs::create_directories(zip_path.parent_path());
 
     // Write ZIP file
     std::ofstream out(zip_path, std::ios::binary);
@@ -334,20 +472,71 @@ bool BR::write_zip(build* b)
     } 
 
     // Write bytes to ZIP file
-    out.write(reinterpret_cast<const char*>(b->header_data), b->header_size);
+    if (b->base_version.empty())
+    {
+        out.write(reinterpret_cast<const char*>(b->header_data), b->header_size);
+    }
+    else
+    {
+        // delta build, stream the zip back out of its base
+        const build* base = this->registry.find_base(*b);
+        if (!base || !apply_build_delta(base->header_data, base->header_size,
+                                        b->header_data, b->header_size, out))
+        {
+            out.close();
+            fs::remove(zip_path);
+            cout << "[ERROR] could not rebuild " << build_tag(*b)
+                 << " from " << b->name << "@" << b->base_version << endl;
+            cout << "[PROC]Writing Zip Template... " << COLOR_RED << "FAIL" << COLOR_RESET << "\n";
+            return false;
+        }
+    }
     out.close();
     cout << "[PROC]Writing Zip Template... " << COLOR_GREEN << "OK" << COLOR_RESET << "\n";
     return true;
 }
 
-bool BR::unzip(const fs::path& zip_file, const fs::path& dest_dir) 
+// --------------------------------------------------------
+// writes target_zip as a delta against base_zip for REGISTER_BUILD_DELTA
+bool BR::make_delta(const fs::path& base_zip, const fs::path& target_zip, const fs::path& out_file)
+{
+    auto read_all = [](const fs::path& p, vector<unsigned char>& bytes) {
+        std::ifstream in(p, std::ios::binary);
+        if (!in) { return false; }
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        return true;
+    };
+    vector<unsigned char> base, target, delta;
+    if (!read_all(base_zip, base) || !read_all(target_zip, target))
+    {
+        cout << "[PROC]Reading Templates... " << COLOR_RED << "FAIL" << COLOR_RESET << "\n";
+        return false;
+    }
+    make_build_delta(base, target, delta);
+
+    std::ofstream out(out_file, std::ios::binary);
+    if (!out)
+    {
+        cout << "[PROC]Writing Delta... " << COLOR_RED << "FAIL" << COLOR_RESET << "\n";
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(delta.data()), delta.size());
+    out.close();
+    cout << "[PROC]Writing Delta... " << COLOR_GREEN << "OK" << COLOR_RESET << "\n";
+    cout << "DELTA SIZE: " << delta.size() << " (target " << target.size() << ")" << endl;
+    return true;
+}
+
+bool BR::unzip(const fs::path& zip_file, const fs::path& dest_dir, progress_reporter* progress)
 {
     fs::create_directories(dest_dir);
 
+    // the entry listing is only needed when progress is reported from it
+    const bool listing = progress && progress->enabled();
     #ifdef _WIN32
         // Windows 10+ has tar built-in, use it for cross-compatibility
         // PowerShell Expand-Archive is also available but tar works better
-        std::string cmd = "tar -xf \"" + zip_file.string() +
+        std::string cmd = string(listing ? "tar -xvf \"" : "tar -xf \"") + zip_file.string() +
                         "\" -C \"" + dest_dir.string() + "\"";
     #elif defined(__APPLE__) || defined(__linux__)
         std::string cmd = "unzip -o \"" + zip_file.string() +
@@ -357,25 +546,96 @@ bool BR::unzip(const fs::path& zip_file, const fs::path& dest_dir)
         std::string cmd = "unzip -o \"" + zip_file.string() +
                         "\" -d \"" + dest_dir.string() + "\"";
     #endif
+    if (!listing)
+    {
         if (std::system(cmd.c_str()) != 0)
             return false;
-    return true;
+        return true;
+    }
+
+    // report progress from the extractor's one line per entry listing,
+    // sizes come from the zip's central directory. This is a parse of
+    // unzip / tar -v text on this thread, not a count from the writes:
+    // an entry is credited when its line is printed, and a name the
+    // extractor escapes or shortens misses its size and counts 0 bytes
+    progress->load_zip_totals(zip_file);
+    progress->start("extract", progress->zip_bytes_total(), progress->zip_entries_total());
+    #ifdef _WIN32
+        // tar -v lists entries on stderr, so it has to share the pipe
+        FILE* pipe = _popen((cmd + " 2>&1").c_str(), "r");
+    #else
+        // unzip's errors stay on stderr and reach the user as they happen;
+        // merged into the pipe they land in the middle of a listing line
+        FILE* pipe = popen(cmd.c_str(), "r");
+    #endif
+    if (!pipe)
+    {
+        progress->stop();
+        return false;
+    }
+    // the extractor writes one line per entry; reading the pipe in big
+    // chunks with a short pause between them lets lines pile up, so this
+    // thread wakes a few hundred times a second instead of once per entry
+    const string prefix = dest_dir.string() + "/";
+    const int    fd     = fileno(pipe);
+    string pending;
+    // lines that are not entries are the extractor's own messages,
+    // the last few are printed if it fails
+    vector<string> messages;
+    vector<char> chunk(1 << 16);
+    for (;;)
+    {
+        #ifdef _WIN32
+            int got = _read(fd, chunk.data(), static_cast<unsigned int>(chunk.size()));
+        #else
+            ssize_t got = read(fd, chunk.data(), chunk.size());
+            if (got < 0 && errno == EINTR) { continue; }
+        #endif
+        if (got <= 0) { break; }
+        pending.append(chunk.data(), static_cast<size_t>(got));
+        size_t begin = 0;
+        for (size_t end = pending.find('\n'); end != string::npos; end = pending.find('\n', begin))
+        {
+            string line = pending.substr(begin, end + 1 - begin);
+            string name = extracted_entry(line, prefix);
+            if (!name.empty()) { progress->entry_done(name); }
+            else { keep_message(messages, line); }
+            begin = end + 1;
+        }
+        pending.erase(0, begin);
+        std::this_thread::sleep_for(PIPE_BATCH_DELAY);
+    }
+    #ifdef _WIN32
+        int status = _pclose(pipe);
+    #else
+        int status = pclose(pipe);
+    #endif
+    progress->stop();
+    if (status != 0)
+    {
+        keep_message(messages, pending);
+        for (const string& line : messages)
+        {
+            cout << "[ERROR] " << line << endl;
+        }
+    }
+    return status == 0;
 }
 
-bool BR::clean_up(const fs::path& zip_file)
+bool BR::clean_up(const fs::path& staging)
 {
-    // Use filesystem library for cross-platform file deletion
+    // Use filesystem library for cross-platform deletion of the zip and staging folder
     try {
-        if (fs::exists(zip_file)) {
-            fs::remove(zip_file);
+        if (fs::exists(staging)) {
+            fs::remove_all(staging);
             return true;
         }
     } catch (const fs::filesystem_error& e) {
         // Fallback to system command if filesystem library fails
         #ifdef _WIN32
-            std::string cmd = "del /f /q \"" + zip_file.string() + "\"";
+            std::string cmd = "rmdir /s /q \"" + staging.string() + "\"";
         #else
-            std::string cmd = "rm -f \"" + zip_file.string() + "\"";
+            std::string cmd = "rm -rf \"" + staging.string() + "\"";
         #endif
         if (std::system(cmd.c_str()) != 0)
             return false;
@@ -15,6 +15,7 @@ DATE:   01/16/2026
 
 */
 #include "buildRegistry.h"
+#include "progress.h"
 #include <filesystem>
 using namespace std;
 namespace fs = filesystem;
@@ -25,6 +26,9 @@ struct USER_CONFIG {
     string template_name        = "";
     string project_name         = "boilr-template";
     string project_destination  = ".";
+    bool   git_init             = false;    // create a repo with an initial commit
+    string progress_mode        = "auto";   // auto, tty, json or none
+    string sync_policy          = "none";   // none, batch or strict (see durability.h)
 };
 
 class boilr
@@ -54,9 +58,13 @@ bool    verify_id(map<unsigned int, build>& builds, const int id);
 int     verify_template_name(map<unsigned int, build>& builds, const string name);
 bool    verify_destination(const string name);
 bool    insert(build* b);
-bool    write_zip(build* b);
-bool    unzip(const fs::path& zip_file, const fs::path& dest_dir);
-bool    clean_up(const fs::path& zip_file);
+bool    write_zip(build* b, const fs::path& zip_path);
+bool    unzip(const fs::path& zip_file, const fs::path& dest_dir, progress_reporter* progress = nullptr);
+bool    clean_up(const fs::path& staging);
+fs::path staging_dir(const fs::path& dest_dir, const string& project_name);
+
+// template authoring
+bool    make_delta(const fs::path& base_zip, const fs::path& target_zip, const fs::path& out_file);
 
 
 private:
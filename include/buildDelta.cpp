@@ -0,0 +1,172 @@
+#include "buildDelta.h"
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+    const unsigned char DELTA_MAGIC[4] = {'B', 'R', 'D', '1'};
+    const unsigned char OP_ADD  = 0x00;
+    const unsigned char OP_COPY = 0x01;
+
+    // block length used to find matches between base and target
+    const size_t   BLOCK     = 32;
+    const uint64_t HASH_MULT = 1099511628211ULL;
+
+    void put_varint(vector<unsigned char>& out, uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            out.push_back(static_cast<unsigned char>(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<unsigned char>(v));
+    }
+
+    bool get_varint(const unsigned char* data, size_t size, size_t& pos, uint64_t& v)
+    {
+        v = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (pos >= size) { return false; }
+            unsigned char c = data[pos++];
+            v |= static_cast<uint64_t>(c & 0x7f) << shift;
+            if (!(c & 0x80)) { return true; }
+        }
+        return false;
+    }
+
+    // polynomial hash of BLOCK bytes, rollable one byte at a time
+    uint64_t block_hash(const unsigned char* p)
+    {
+        uint64_t h = 0;
+        for (size_t i = 0; i < BLOCK; i++) { h = h * HASH_MULT + p[i]; }
+        return h;
+    }
+
+    void emit_add(vector<unsigned char>& delta, const unsigned char* p, size_t len)
+    {
+        if (len == 0) { return; }
+        delta.push_back(OP_ADD);
+        put_varint(delta, len);
+        delta.insert(delta.end(), p, p + len);
+    }
+
+    void emit_copy(vector<unsigned char>& delta, size_t offset, size_t len)
+    {
+        delta.push_back(OP_COPY);
+        put_varint(delta, offset);
+        put_varint(delta, len);
+    }
+}
+
+bool apply_build_delta(const unsigned char* base, size_t base_size,
+                       const unsigned char* delta, size_t delta_size,
+                       ostream& out)
+{
+    if (delta_size < sizeof(DELTA_MAGIC) || memcmp(delta, DELTA_MAGIC, sizeof(DELTA_MAGIC)) != 0)
+    {
+        return false;
+    }
+    size_t   pos = sizeof(DELTA_MAGIC);
+    uint64_t expected_base, target_size;
+    if (!get_varint(delta, delta_size, pos, expected_base) ||
+        !get_varint(delta, delta_size, pos, target_size))
+    {
+        return false;
+    }
+    // delta was made against a different base
+    if (expected_base != base_size) { return false; }
+
+    uint64_t written = 0;
+    while (pos < delta_size)
+    {
+        unsigned char op = delta[pos++];
+        uint64_t len;
+        if (op == OP_ADD)
+        {
+            if (!get_varint(delta, delta_size, pos, len) || len > delta_size - pos) { return false; }
+            out.write(reinterpret_cast<const char*>(delta + pos), len);
+            pos += len;
+        }
+        else if (op == OP_COPY)
+        {
+            uint64_t offset;
+            if (!get_varint(delta, delta_size, pos, offset) ||
+                !get_varint(delta, delta_size, pos, len) ||
+                offset > base_size || len > base_size - offset)
+            {
+                return false;
+            }
+            out.write(reinterpret_cast<const char*>(base + offset), len);
+        }
+        else
+        {
+            return false;
+        }
+        written += len;
+    }
+    return written == target_size && static_cast<bool>(out);
+}
+
+void make_build_delta(const vector<unsigned char>& base,
+                      const vector<unsigned char>& target,
+                      vector<unsigned char>& delta)
+{
+    delta.clear();
+    delta.insert(delta.end(), DELTA_MAGIC, DELTA_MAGIC + sizeof(DELTA_MAGIC));
+    put_varint(delta, base.size());
+    put_varint(delta, target.size());
+
+    const unsigned char* b = base.data();
+    const unsigned char* t = target.data();
+
+    // index block aligned offsets of the base (first occurrence wins)
+    unordered_map<uint64_t, size_t> index;
+    if (base.size() >= BLOCK)
+    {
+        index.reserve(base.size() / BLOCK + 1);
+        for (size_t off = 0; off + BLOCK <= base.size(); off += BLOCK)
+        {
+            index.emplace(block_hash(b + off), off);
+        }
+    }
+
+    // HASH_MULT^(BLOCK-1), used to drop the leading byte when rolling
+    uint64_t top = 1;
+    for (size_t i = 1; i < BLOCK; i++) { top *= HASH_MULT; }
+
+    size_t literal = 0;   // start of bytes not yet emitted
+    size_t p       = 0;
+    bool   rolled  = false;
+    uint64_t h     = 0;
+    while (!index.empty() && p + BLOCK <= target.size())
+    {
+        h = rolled ? h : block_hash(t + p);
+        rolled = true;
+
+        auto hit = index.find(h);
+        if (hit != index.end() && memcmp(b + hit->second, t + p, BLOCK) == 0)
+        {
+            size_t src = hit->second;
+            size_t dst = p;
+            // grow the match backwards into pending literals
+            while (dst > literal && src > 0 && b[src - 1] == t[dst - 1]) { src--; dst--; }
+            // and forwards as far as both buffers agree
+            size_t len = p - dst + BLOCK;
+            while (dst + len < target.size() && src + len < base.size() && b[src + len] == t[dst + len]) { len++; }
+
+            emit_add(delta, t + literal, dst - literal);
+            emit_copy(delta, src, len);
+            p       = dst + len;
+            literal = p;
+            rolled  = false;
+            continue;
+        }
+        if (p + BLOCK < target.size())
+        {
+            h = (h - t[p] * top) * HASH_MULT + t[p + BLOCK];
+        }
+        p++;
+    }
+    emit_add(delta, t + literal, target.size() - literal);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+/**
+BRIEF:
+    Binary deltas for versioned templates. A versioned build
+    (name@version) can be embedded as the difference against a
+    full base build of the same name instead of a full zip copy,
+    so the binary grows by the size of the diff only.
+
+FORMAT:
+    "BRD1" | varint base_size | varint target_size | ops...
+    op 0x00 ADD  : varint len, len literal bytes
+    op 0x01 COPY : varint base_offset, varint len
+
+    Make one with: br -MD base.zip target.zip target.delta
+    then embed it: xxd -i target.delta > target.h
+
+*/
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+// reconstructs the target by streaming ops straight into out,
+// returns false on a malformed delta or a base size mismatch
+bool apply_build_delta(const unsigned char* base, size_t base_size,
+                       const unsigned char* delta, size_t delta_size,
+                       ostream& out);
+
+// encodes target as a delta against base
+void make_build_delta(const vector<unsigned char>& base,
+                      const vector<unsigned char>& target,
+                      vector<unsigned char>& delta);
@@ -43,13 +43,24 @@ struct build
     unsigned char*  header_data;
     size_t          header_size;
     string          path;
+    string          version;        // optional tag, selected with -TN name@version
+    string          base_version;   // when set, header_data is a delta against name@base_version
 };
 
+// full name of a build as shown in the registry (name or name@version)
+inline string build_tag(const build& b)
+{
+    return b.version.empty() ? b.name : b.name + "@" + b.version;
+}
+
 // Macros to construct variable names from base name
 // xxd -i creates: name_zip[] and name_zip_len
 // Note: xxd uses the filename (without extension) + "_zip" and "_zip_len"
 #define BUILD_DATA(name) name##_zip
 #define BUILD_SIZE(name) name##_zip_len
+// xxd -i on a .delta file creates: name_delta[] and name_delta_len
+#define BUILD_DELTA_DATA(name) name##_delta
+#define BUILD_DELTA_SIZE(name) name##_delta_len
 
 class build_registery
 {
@@ -69,7 +80,8 @@ map<unsigned int, build> registery;
 // Register a build with direct pointers to the byte data
 // data_ptr: pointer to the unsigned char array from the header file
 // data_size: size_t value from the header file
-void register_build(string name, unsigned char* data_ptr, size_t data_size, string path)
+void register_build(string name, unsigned char* data_ptr, size_t data_size, string path,
+                    string version = "", string base_version = "")
 {
     // catch invalid input
     if (name.size() == 0 || path.size() == 0){
@@ -80,12 +92,18 @@ void register_build(string name, unsigned char* data_ptr, size_t data_size, stri
         printf("Invalid build data: data pointer is null or size is zero\n");
         return;
     }
+    if (!base_version.empty() && (version.empty() || version == base_version)){
+        printf("Invalid delta build: %s needs a version different from its base\n", name.c_str());
+        return;
+    }
     // create build
     build b{
         name,
         data_ptr,      // pointer to the byte array
         data_size,     // size of the byte array
-        path
+        path,
+        version,
+        base_version
     };
     // add to the registry
     int id = registery.size();
@@ -103,12 +121,31 @@ void print_registry()
     cout << "========================================" << endl;
     for (auto build : registery)
     {
-        printf("ID: %d  NAME: %s  PATH: %s\n", 
+        printf("ID: %d  NAME: %s  PATH: %s", 
             build.first, 
-            build.second.name.c_str(),
+            build_tag(build.second).c_str(),
             build.second.path.c_str()
         );
+        if (!build.second.base_version.empty()){
+            printf("  DELTA OF: %s@%s", build.second.name.c_str(), build.second.base_version.c_str());
+        }
+        printf("\n");
+    }
+}
+
+// finds the full build a delta build was made against
+// returns nullptr if the base is missing or is itself a delta
+const build* find_base(const build& b) const
+{
+    for (auto& pair : registery)
+    {
+        const build& candidate = pair.second;
+        if (candidate.name == b.name && candidate.version == b.base_version)
+        {
+            return candidate.base_version.empty() ? &candidate : nullptr;
+        }
     }
+    return nullptr;
 }
 
 map<unsigned int, build> getBuilds()
@@ -128,9 +165,14 @@ private:
 // Example: REGISTER_BUILD("test-build", test_build_1, "templates/test_build_1.h")
 //          This will use test_build_1_zip[] and test_build_1_len from the header file
 
+// __LINE__ has to be expanded before pasting, otherwise every
+// registration declares the same _register_build___LINE__ variable
+#define BUILD_CONCAT_INNER(a, b) a##b
+#define BUILD_CONCAT(a, b) BUILD_CONCAT_INNER(a, b)
+
 #define REGISTER_BUILD(name, base_name, path) \
     namespace { \
-        static bool _register_build_##__LINE__ = []() { \
+        static bool BUILD_CONCAT(_register_build_, __LINE__) = []() { \
             build_registery::Instance().register_build( \
                 name, \
                 BUILD_DATA(base_name), \
@@ -141,6 +183,48 @@ private:
         }(); \
     }
 
+// MACRO FOR REGISTERING VERSIONED BUILDS
+// Same as REGISTER_BUILD but tags the full zip with a version,
+// so it can be selected with -TN name@version and used as a delta base
+//
+// Usage: REGISTER_BUILD_VERSION("spring-boot", "2", spring_boot_2, "templates/spring_boot_2.h")
+
+#define REGISTER_BUILD_VERSION(name, version, base_name, path) \
+    namespace { \
+        static bool BUILD_CONCAT(_register_build_, __LINE__) = []() { \
+            build_registery::Instance().register_build( \
+                name, \
+                BUILD_DATA(base_name), \
+                BUILD_SIZE(base_name), \
+                path, \
+                version \
+            ); \
+            return true; \
+        }(); \
+    }
+
+// MACRO FOR REGISTERING DELTA BUILDS
+// Embeds only the difference against name@base_version (which must be
+// registered with REGISTER_BUILD_VERSION); the zip is rebuilt on extraction
+//
+// Usage: REGISTER_BUILD_DELTA("spring-boot", "3", "2", spring_boot_3, "templates/spring_boot_3.h")
+//          This will use spring_boot_3_delta[] and spring_boot_3_delta_len from the header file
+
+#define REGISTER_BUILD_DELTA(name, version, base_version, base_name, path) \
+    namespace { \
+        static bool BUILD_CONCAT(_register_build_, __LINE__) = []() { \
+            build_registery::Instance().register_build( \
+                name, \
+                BUILD_DELTA_DATA(base_name), \
+                BUILD_DELTA_SIZE(base_name), \
+                path, \
+                version, \
+                base_version \
+            ); \
+            return true; \
+        }(); \
+    }
+
 
 
 
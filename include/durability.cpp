@@ -0,0 +1,222 @@
+// Include Windows headers FIRST with proper defines to avoid byte conflict
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+    #ifdef byte
+        #undef byte
+    #endif
+#else
+    #include <cerrno>
+    #include <cstring>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+#include "durability.h"
+#include <system_error>
+
+namespace {
+    // "path: reason" for the error that just happened
+    string failure(const fs::path& path)
+    {
+        #ifdef _WIN32
+            return path.string() + ": " + std::system_category().message(static_cast<int>(GetLastError()));
+        #else
+            return path.string() + ": " + strerror(errno);
+        #endif
+    }
+
+    #ifndef _WIN32
+        // fsync only reaches the drive's cache on macOS, F_FULLFSYNC
+        // flushes that too when drive_cache is set; filesystems that do
+        // not support it get a plain fsync, any other error is a failure
+        bool flush_fd(int fd, bool data_only, bool drive_cache)
+        {
+            #if defined(__APPLE__)
+                (void)data_only;
+                if (drive_cache)
+                {
+                    if (fcntl(fd, F_FULLFSYNC) == 0) { return true; }
+                    if (errno != ENOTSUP && errno != EINVAL) { return false; }
+                }
+                return fsync(fd) == 0;
+            #elif defined(__linux__)
+                (void)drive_cache;
+                return (data_only ? fdatasync(fd) : fsync(fd)) == 0;
+            #else
+                (void)data_only;
+                (void)drive_cache;
+                return fsync(fd) == 0;
+            #endif
+        }
+    #endif
+
+    bool sync_file(const fs::path& file, bool drive_cache, string& error)
+    {
+        #ifdef _WIN32
+            (void)drive_cache;
+            HANDLE h = CreateFileW(file.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                   NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+            DWORD attributes = INVALID_FILE_ATTRIBUTES;
+            if (h == INVALID_HANDLE_VALUE && GetLastError() == ERROR_ACCESS_DENIED)
+            {
+                // FlushFileBuffers needs write access, which a read-only
+                // file refuses: lift the attribute for the flush only
+                attributes = GetFileAttributesW(file.c_str());
+                if (attributes == INVALID_FILE_ATTRIBUTES || !(attributes & FILE_ATTRIBUTE_READONLY))
+                {
+                    SetLastError(ERROR_ACCESS_DENIED);
+                    error = failure(file);
+                    return false;
+                }
+                if (!SetFileAttributesW(file.c_str(), attributes & ~FILE_ATTRIBUTE_READONLY))
+                {
+                    error = failure(file);
+                    return false;
+                }
+                h = CreateFileW(file.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+            }
+            bool ok = h != INVALID_HANDLE_VALUE && FlushFileBuffers(h) != 0;
+            if (!ok) { error = failure(file); }
+            if (h != INVALID_HANDLE_VALUE) { CloseHandle(h); }
+            if (attributes != INVALID_FILE_ATTRIBUTES && !SetFileAttributesW(file.c_str(), attributes))
+            {
+                if (ok) { error = failure(file); }
+                ok = false;
+            }
+            return ok;
+        #else
+            int fd = open(file.c_str(), O_RDONLY);
+            if (fd < 0)
+            {
+                error = failure(file);
+                return false;
+            }
+            bool ok = flush_fd(fd, true, drive_cache);
+            if (!ok) { error = failure(file); }
+            close(fd);
+            return ok;
+        #endif
+    }
+
+    enum fs_sync_result { FS_SYNCED, FS_SYNC_FAILED, FS_SYNC_UNSUPPORTED };
+
+    // one call that flushes everything on the filesystem holding path;
+    // a failing syncfs is a real writeback error and is reported as such
+    fs_sync_result sync_filesystem(const fs::path& path, string& error)
+    {
+        #ifdef __linux__
+            int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY);
+            if (fd < 0)
+            {
+                error = failure(path);
+                return FS_SYNC_FAILED;
+            }
+            int rc = syncfs(fd);
+            int err = errno;
+            close(fd);
+            if (rc == 0) { return FS_SYNCED; }
+            if (err == ENOSYS) { return FS_SYNC_UNSUPPORTED; }
+            errno = err;
+            error = "syncfs " + failure(path);
+            return FS_SYNC_FAILED;
+        #else
+            (void)path;
+            (void)error;
+            return FS_SYNC_UNSUPPORTED;
+        #endif
+    }
+
+    // strict flushes each file through to the drive; the batch sweep
+    // leaves that to one drive cache flush at the end (see sync_tree)
+    bool sync_each(const fs::path& root, bool directories, bool drive_cache, string& error)
+    {
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(root, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec))
+        {
+            fs::file_status status = it->symlink_status();
+            if (fs::is_regular_file(status) && !sync_file(it->path(), drive_cache, error)) { return false; }
+            if (directories && fs::is_directory(status) && !sync_directory(it->path(), error)) { return false; }
+        }
+        if (ec)
+        {
+            error = root.string() + ": " + ec.message();
+            return false;
+        }
+        return !directories || sync_directory(root, error);
+    }
+
+    // F_FULLFSYNC flushes the whole drive cache, so one call on any
+    // descriptor of the filesystem covers every file fsynced before it
+    bool flush_drive_cache(const fs::path& root, string& error)
+    {
+        #ifdef __APPLE__
+            int fd = open(root.c_str(), O_RDONLY | O_DIRECTORY);
+            if (fd < 0)
+            {
+                error = failure(root);
+                return false;
+            }
+            bool ok = flush_fd(fd, false, true);
+            if (!ok) { error = failure(root); }
+            close(fd);
+            return ok;
+        #else
+            (void)root;
+            (void)error;
+            return true;
+        #endif
+    }
+}
+
+bool valid_sync_policy(const string& policy)
+{
+    return policy == "none" || policy == "batch" || policy == "strict";
+}
+
+bool sync_tree(const fs::path& root, const string& policy, string& error)
+{
+    if (policy == "strict")
+    {
+        return sync_each(root, true, true, error);
+    }
+    if (policy == "batch")
+    {
+        fs_sync_result result = sync_filesystem(root, error);
+        if (result != FS_SYNC_UNSUPPORTED)
+        {
+            return result == FS_SYNCED;
+        }
+        // no single call for that on this platform, sweep the files
+        // with plain fsyncs and flush the drive cache once
+        return sync_each(root, false, false, error) && flush_drive_cache(root, error);
+    }
+    return true;
+}
+
+bool sync_directory(const fs::path& dir, string& error)
+{
+    #ifdef _WIN32
+        // NTFS journals directory entries, there is no directory handle to flush
+        (void)dir;
+        (void)error;
+        return true;
+    #else
+        int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd < 0)
+        {
+            error = failure(dir);
+            return false;
+        }
+        bool ok = flush_fd(fd, false, true);
+        if (!ok) { error = failure(dir); }
+        close(fd);
+        return ok;
+    #endif
+}
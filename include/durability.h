@@ -0,0 +1,36 @@
+#pragma once
+
+/**
+BRIEF:
+    Durability policies for a written project (--sync).
+
+    none    no syncs, fastest, for ephemeral CI machines
+    batch   one filesystem wide sweep (syncfs on Linux; where syncfs
+            does not exist, a plain fsync per file and one drive cache
+            flush at the end) before the project is renamed into place,
+            then an fsync of the destination directory; a syncfs error
+            fails the sync, it is not retried
+    strict  fsync of every file and directory in the project before
+            the rename, then an fsync of the destination directory.
+            macOS uses F_FULLFSYNC so the drive cache is flushed too;
+            Windows lifts a read-only attribute for the flush and puts
+            it back
+
+    The zip written to the staging folder is scratch data and is
+    never synced under any policy.
+
+*/
+#include <filesystem>
+#include <string>
+using namespace std;
+namespace fs = filesystem;
+
+bool valid_sync_policy(const string& policy);
+
+// makes the finished tree under root durable per policy,
+// called before the tree is renamed into its final place;
+// on failure error names the path and the reason
+bool sync_tree(const fs::path& root, const string& policy, string& error);
+
+// persists directory entries (e.g. the rename) of dir
+bool sync_directory(const fs::path& dir, string& error);
@@ -0,0 +1,983 @@
+#include "gitInit.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+    #include <sys/stat.h>
+#endif
+
+namespace {
+    typedef array<unsigned char, 20> object_id;
+
+    const int OBJ_COMMIT = 1;
+    const int OBJ_TREE   = 2;
+    const int OBJ_BLOB   = 3;
+
+    // bytes of loaded blobs and pack records that hashing may hold ahead
+    // of the pack writer; the blob the writer waits on is always admitted
+    const uint64_t WINDOW_BYTES = 64ull << 20;
+
+    // blobs above this are hashed in chunks and copied into the pack by
+    // the writer rather than held in memory
+    const uint64_t STREAM_THRESHOLD = 8ull << 20;
+
+    const size_t STREAM_CHUNK = 1 << 20;
+
+    //------------------------------------------------------------------
+    // SHA-1, as used for git object ids and pack/index checksums
+    class sha1
+    {
+    public:
+        sha1() { reset(); }
+
+        void reset()
+        {
+            h[0] = 0x67452301; h[1] = 0xEFCDAB89; h[2] = 0x98BADCFE;
+            h[3] = 0x10325476; h[4] = 0xC3D2E1F0;
+            length = 0;
+            used   = 0;
+        }
+
+        void update(const void* data, size_t n)
+        {
+            const unsigned char* p = static_cast<const unsigned char*>(data);
+            length += n;
+            if (used)
+            {
+                size_t take = min(n, sizeof(block) - used);
+                memcpy(block + used, p, take);
+                used += take; p += take; n -= take;
+                if (used < sizeof(block)) { return; }
+                compress(block);
+                used = 0;
+            }
+            for (; n >= sizeof(block); p += sizeof(block), n -= sizeof(block)) { compress(p); }
+            memcpy(block, p, n);
+            used = n;
+        }
+
+        object_id digest()
+        {
+            uint64_t bits = length * 8;
+            unsigned char pad = 0x80;
+            update(&pad, 1);
+            pad = 0;
+            while (used != 56) { update(&pad, 1); }
+            unsigned char len_be[8];
+            for (int i = 0; i < 8; i++) { len_be[i] = static_cast<unsigned char>(bits >> (56 - 8 * i)); }
+            update(len_be, 8);
+            object_id out;
+            for (int i = 0; i < 20; i++) { out[i] = static_cast<unsigned char>(h[i / 4] >> (24 - 8 * (i % 4))); }
+            return out;
+        }
+
+    private:
+        uint32_t      h[5];
+        uint64_t      length;
+        unsigned char block[64];
+        size_t        used;
+
+        static uint32_t rol(uint32_t v, int s) { return (v << s) | (v >> (32 - s)); }
+
+        void compress(const unsigned char* p)
+        {
+            uint32_t w[80];
+            for (int i = 0; i < 16; i++)
+            {
+                w[i] = (uint32_t(p[4 * i]) << 24) | (uint32_t(p[4 * i + 1]) << 16) |
+                       (uint32_t(p[4 * i + 2]) << 8) | uint32_t(p[4 * i + 3]);
+            }
+            for (int i = 16; i < 80; i++) { w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1); }
+            uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+            for (int i = 0; i < 80; i++)
+            {
+                uint32_t f, k;
+                if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+                else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+                else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+                else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+                uint32_t t = rol(a, 5) + f + e + k + w[i];
+                e = d; d = c; c = rol(b, 30); b = a; a = t;
+            }
+            h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+        }
+    };
+
+    //------------------------------------------------------------------
+    // CRC-32 of each packed object, stored in the pack index
+    uint32_t crc32_update(uint32_t crc, const unsigned char* p, size_t n)
+    {
+        static const vector<uint32_t> table = [] {
+            vector<uint32_t> t(256);
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++) { c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1; }
+                t[i] = c;
+            }
+            return t;
+        }();
+        crc = ~crc;
+        for (size_t i = 0; i < n; i++) { crc = table[(crc ^ p[i]) & 0xff] ^ (crc >> 8); }
+        return ~crc;
+    }
+
+    string to_hex(const object_id& id)
+    {
+        static const char* digits = "0123456789abcdef";
+        string out;
+        for (unsigned char c : id) { out += digits[c >> 4]; out += digits[c & 0xf]; }
+        return out;
+    }
+
+    void put_be32(string& out, uint32_t v)
+    {
+        for (int i = 3; i >= 0; i--) { out += static_cast<char>(v >> (8 * i)); }
+    }
+
+    void put_be16(string& out, uint16_t v)
+    {
+        out += static_cast<char>(v >> 8);
+        out += static_cast<char>(v);
+    }
+
+    // "<type> <size>\0<data>" hashed the way git names loose objects
+    object_id hash_object(const char* type, const string& data)
+    {
+        string header = string(type) + " " + to_string(data.size());
+        sha1 s;
+        s.update(header.c_str(), header.size() + 1);
+        s.update(data.data(), data.size());
+        return s.digest();
+    }
+
+    // pack entry: type/size varint header + zlib stream of stored blocks,
+    // fed in pieces so large blobs never have to be held whole; encoded
+    // bytes collect in out until the caller takes them
+    class record_encoder
+    {
+    public:
+        string out;
+
+        void begin(int type, uint64_t size)
+        {
+            left = size;
+            a = 1; b = 0;
+            unsigned char c = static_cast<unsigned char>((type << 4) | (size & 0x0f));
+            size >>= 4;
+            while (size)
+            {
+                out += static_cast<char>(c | 0x80);
+                c = static_cast<unsigned char>(size & 0x7f);
+                size >>= 7;
+            }
+            out += static_cast<char>(c);
+            out += static_cast<char>(0x78);
+            out += static_cast<char>(0x01);
+            if (!left) { block(); }
+        }
+
+        // false when more bytes arrive than begin() announced
+        bool feed(const char* p, size_t n)
+        {
+            if (n > left) { return false; }
+            adler(reinterpret_cast<const unsigned char*>(p), n);
+            while (n)
+            {
+                size_t take = min(n, 65535 - pending.size());
+                pending.append(p, take);
+                p += take; n -= take; left -= take;
+                if (pending.size() == 65535 || !left) { block(); }
+            }
+            return true;
+        }
+
+        // false when fewer bytes arrived than begin() announced
+        bool finish()
+        {
+            if (left) { return false; }
+            put_be32(out, (b << 16) | a);
+            return true;
+        }
+
+    private:
+        uint64_t left = 0;
+        string   pending;
+        uint32_t a = 1, b = 0;
+
+        void block()
+        {
+            uint16_t len = static_cast<uint16_t>(pending.size());
+            out += static_cast<char>(left ? 0 : 1);
+            out += static_cast<char>(len & 0xff);
+            out += static_cast<char>(len >> 8);
+            out += static_cast<char>(~len & 0xff);
+            out += static_cast<char>((~len >> 8) & 0xff);
+            out += pending;
+            pending.clear();
+        }
+
+        void adler(const unsigned char* p, size_t n)
+        {
+            while (n)
+            {
+                size_t chunk = min<size_t>(n, 5552);
+                for (size_t i = 0; i < chunk; i++) { a += p[i]; b += a; }
+                a %= 65521; b %= 65521;
+                p += chunk; n -= chunk;
+            }
+        }
+    };
+
+    string pack_record(int type, const string& data)
+    {
+        record_encoder enc;
+        enc.out.reserve(data.size() + data.size() / 65535 * 5 + 32);
+        enc.begin(type, data.size());
+        enc.feed(data.data(), data.size());
+        enc.finish();
+        return std::move(enc.out);
+    }
+
+    //------------------------------------------------------------------
+    struct file_entry
+    {
+        string   path;      // relative to root, '/' separated
+        fs::path full;
+        uint32_t mode;      // 0100644, 0100755 or 0120000
+        object_id id;
+        uint32_t stat_fields[8] = {};  // ctime s/ns, mtime s/ns, dev, ino, uid, gid
+        uint32_t size = 0;
+        uint64_t bytes = 0;  // size seen when the tree was walked
+        bool     streamed = false;
+    };
+
+    struct pack_entry
+    {
+        object_id id;
+        uint32_t  crc;
+        uint64_t  offset;
+    };
+
+    struct tree_item
+    {
+        string    name;
+        uint32_t  mode;
+        object_id id;
+    };
+
+    // fills in the stat fields the index needs
+    void stat_file(file_entry& f)
+    {
+        #ifndef _WIN32
+            struct stat st;
+            if (lstat(f.full.c_str(), &st) == 0)
+            {
+                #ifdef __APPLE__
+                    f.stat_fields[0] = st.st_ctimespec.tv_sec; f.stat_fields[1] = st.st_ctimespec.tv_nsec;
+                    f.stat_fields[2] = st.st_mtimespec.tv_sec; f.stat_fields[3] = st.st_mtimespec.tv_nsec;
+                #else
+                    f.stat_fields[0] = st.st_ctim.tv_sec; f.stat_fields[1] = st.st_ctim.tv_nsec;
+                    f.stat_fields[2] = st.st_mtim.tv_sec; f.stat_fields[3] = st.st_mtim.tv_nsec;
+                #endif
+                f.stat_fields[4] = st.st_dev;
+                f.stat_fields[5] = st.st_ino;
+                f.stat_fields[6] = st.st_uid;
+                f.stat_fields[7] = st.st_gid;
+            }
+        #else
+            (void)f;
+        #endif
+    }
+
+    // reads a file (or symlink target) and fills in what the index needs
+    bool load_file(file_entry& f, string& content)
+    {
+        if (f.mode == 0120000)
+        {
+            std::error_code ec;
+            content = fs::read_symlink(f.full, ec).string();
+            if (ec) { return false; }
+        }
+        else
+        {
+            std::ifstream in(f.full, std::ios::binary);
+            if (!in) { return false; }
+            content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        f.size = static_cast<uint32_t>(content.size());
+        stat_file(f);
+        return true;
+    }
+
+    // hashes a large blob a chunk at a time; its bytes go into the pack
+    // later through copy_blob, so only the id is kept here
+    bool hash_streamed(file_entry& f, progress_reporter* progress)
+    {
+        std::ifstream in(f.full, std::ios::binary);
+        if (!in) { return false; }
+        string header = "blob " + to_string(f.bytes);
+        sha1 s;
+        s.update(header.c_str(), header.size() + 1);
+        vector<char> chunk(STREAM_CHUNK);
+        uint64_t total = 0;
+        while (in.read(chunk.data(), chunk.size()) || in.gcount() > 0)
+        {
+            size_t n = static_cast<size_t>(in.gcount());
+            s.update(chunk.data(), n);
+            total += n;
+            if (progress) { progress->add(n, 0); }
+        }
+        if (progress) { progress->add(0); }
+        if (total != f.bytes) { return false; }
+        f.id   = s.digest();
+        f.size = static_cast<uint32_t>(total);
+        stat_file(f);
+        return true;
+    }
+
+    // git orders tree entries by name, with directories compared as "name/"
+    bool tree_order(const tree_item& a, const tree_item& b)
+    {
+        string ka = a.mode == 040000 ? a.name + "/" : a.name;
+        string kb = b.mode == 040000 ? b.name + "/" : b.name;
+        return ka < kb;
+    }
+
+    string mode_string(uint32_t mode)
+    {
+        switch (mode)
+        {
+            case 040000:  return "40000";
+            case 0100755: return "100755";
+            case 0120000: return "120000";
+            default:      return "100644";
+        }
+    }
+
+    string parent_of(const string& path)
+    {
+        size_t slash = path.rfind('/');
+        return slash == string::npos ? "" : path.substr(0, slash);
+    }
+
+    string env_or(const char* name, const string& fallback)
+    {
+        const char* v = std::getenv(name);
+        return (v && *v) ? string(v) : fallback;
+    }
+
+    //------------------------------------------------------------------
+    // the few settings git commit / git init would take from the user's
+    // git config: "section.key" (lower case) -> value, later files win
+    typedef map<string, string> git_config;
+
+    // one value of a config line: quotes, escapes and trailing comments
+    string config_value(const string& raw)
+    {
+        string value;
+        bool quoted = false;
+        size_t pending_space = 0;
+        for (size_t i = 0; i < raw.size(); i++)
+        {
+            char c = raw[i];
+            if (c == '"') { quoted = !quoted; continue; }
+            if (!quoted && (c == '#' || c == ';')) { break; }
+            if (c == '\\' && i + 1 < raw.size())
+            {
+                char e = raw[++i];
+                c = e == 'n' ? '\n' : e == 't' ? '\t' : e;
+            }
+            else if (!quoted && (c == ' ' || c == '\t'))
+            {
+                // inner runs of blanks are kept, trailing ones dropped
+                if (!value.empty()) { pending_space++; }
+                continue;
+            }
+            value.append(pending_space, ' ');
+            pending_space = 0;
+            value += c;
+        }
+        return value;
+    }
+
+    // reads [section] key = value lines; subsections are kept as
+    // "section.sub.key", which none of the keys used here have
+    void read_config_file(const fs::path& file, git_config& config)
+    {
+        std::ifstream in(file);
+        string line, section;
+        while (getline(in, line))
+        {
+            size_t start = line.find_first_not_of(" \t");
+            if (start == string::npos || line[start] == '#' || line[start] == ';') { continue; }
+            if (line[start] == '[')
+            {
+                size_t end = line.find(']', start);
+                if (end == string::npos) { continue; }
+                string header = line.substr(start + 1, end - start - 1);
+                size_t quote = header.find('"');
+                string name = header.substr(0, quote);
+                name.erase(name.find_last_not_of(" \t") + 1);
+                transform(name.begin(), name.end(), name.begin(), ::tolower);
+                section = name;
+                if (quote != string::npos)
+                {
+                    section += "." + header.substr(quote + 1, header.rfind('"') - quote - 1);
+                }
+                continue;
+            }
+            size_t eq = line.find('=', start);
+            if (eq == string::npos || section.empty()) { continue; }
+            string key = line.substr(start, eq - start);
+            key.erase(key.find_last_not_of(" \t") + 1);
+            transform(key.begin(), key.end(), key.begin(), ::tolower);
+            config[section + "." + key] = config_value(line.substr(eq + 1));
+        }
+    }
+
+    // the global config as git reads it: $GIT_CONFIG_GLOBAL alone when
+    // set, otherwise $XDG_CONFIG_HOME/git/config then ~/.gitconfig
+    git_config read_global_config()
+    {
+        git_config config;
+        string global = env_or("GIT_CONFIG_GLOBAL", "");
+        if (!global.empty())
+        {
+            read_config_file(global, config);
+            return config;
+        }
+        #ifdef _WIN32
+            string home = env_or("HOME", env_or("USERPROFILE", ""));
+        #else
+            string home = env_or("HOME", "");
+        #endif
+        string xdg = env_or("XDG_CONFIG_HOME", home.empty() ? "" : home + "/.config");
+        if (!xdg.empty()) { read_config_file(fs::path(xdg) / "git" / "config", config); }
+        if (!home.empty()) { read_config_file(fs::path(home) / ".gitconfig", config); }
+        return config;
+    }
+
+    // "Name <email>" for role ("author" or "committer") in git's order:
+    // GIT_<ROLE>_NAME/EMAIL, <role>.name/email, user.name/email, $EMAIL
+    bool git_identity(const git_config& config, const string& role, string& ident, string& error)
+    {
+        auto setting = [&](const string& key) {
+            auto it = config.find(key);
+            return it == config.end() ? string() : it->second;
+        };
+        string upper = role;
+        transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+        string name  = env_or(("GIT_" + upper + "_NAME").c_str(), setting(role + ".name"));
+        string email = env_or(("GIT_" + upper + "_EMAIL").c_str(), setting(role + ".email"));
+        if (name.empty())  { name  = setting("user.name"); }
+        if (email.empty()) { email = setting("user.email"); }
+        if (email.empty()) { email = env_or("EMAIL", ""); }
+        if (name.empty() || email.empty())
+        {
+            error = "no git " + role + " identity: set user.name and user.email with "
+                    "git config --global, or GIT_" + upper + "_NAME and GIT_" + upper + "_EMAIL";
+            return false;
+        }
+        ident = name + " <" + email + ">";
+        return true;
+    }
+
+    // " <seconds> +hhmm" with the local offset from UTC, as git writes it
+    string git_timestamp()
+    {
+        time_t now = time(nullptr);
+        std::tm local{}, utc{};
+        #ifdef _WIN32
+            localtime_s(&local, &now);
+            gmtime_s(&utc, &now);
+        #else
+            localtime_r(&now, &local);
+            gmtime_r(&now, &utc);
+        #endif
+        // utc read back as local time lands offset seconds before now
+        utc.tm_isdst = local.tm_isdst;
+        long offset = static_cast<long>(difftime(mktime(&local), mktime(&utc)));
+        char zone[8];
+        snprintf(zone, sizeof(zone), "%c%02ld%02ld", offset < 0 ? '-' : '+', labs(offset) / 3600, labs(offset) % 3600 / 60);
+        return " " + to_string(static_cast<long long>(now)) + " " + zone;
+    }
+
+    // what the initial commit is written with, settled before any work
+    struct commit_settings
+    {
+        string author;
+        string committer;
+        string branch;
+    };
+
+    bool read_commit_settings(commit_settings& settings, string& error)
+    {
+        git_config config = read_global_config();
+        if (!git_identity(config, "author", settings.author, error) ||
+            !git_identity(config, "committer", settings.committer, error))
+        {
+            return false;
+        }
+        auto branch = config.find("init.defaultbranch");
+        settings.branch = branch == config.end() || branch->second.empty() ? "master" : branch->second;
+        // the parts of git check-ref-format that would break the ref file
+        const string& b = settings.branch;
+        if (b[0] == '/' || b[0] == '-' || b.back() == '/' || b.back() == '.' || b.find("..") != string::npos ||
+            b.find("//") != string::npos || b.find_first_of(" ~^:?*[\\") != string::npos)
+        {
+            error = "init.defaultBranch '" + b + "' is not a valid branch name";
+            return false;
+        }
+        return true;
+    }
+
+    // writes bytes to the pack while keeping its running checksum
+    class pack_writer
+    {
+    public:
+        std::ofstream out;
+        sha1          sum;
+        uint64_t      offset = 0;
+
+        // copies a streamed blob into the pack, returning its record crc
+        bool copy_blob(const file_entry& f, uint32_t& crc)
+        {
+            std::ifstream in(f.full, std::ios::binary);
+            if (!in) { return false; }
+            record_encoder enc;
+            enc.begin(OBJ_BLOB, f.bytes);
+            vector<char> chunk(STREAM_CHUNK);
+            crc = 0;
+            while (in.read(chunk.data(), chunk.size()) || in.gcount() > 0)
+            {
+                if (!enc.feed(chunk.data(), static_cast<size_t>(in.gcount()))) { return false; }
+                crc = crc32_update(crc, reinterpret_cast<const unsigned char*>(enc.out.data()), enc.out.size());
+                write(enc.out);
+                enc.out.clear();
+            }
+            if (!enc.finish()) { return false; }
+            crc = crc32_update(crc, reinterpret_cast<const unsigned char*>(enc.out.data()), enc.out.size());
+            write(enc.out);
+            return static_cast<bool>(out);
+        }
+
+        void write(const string& bytes)
+        {
+            out.write(bytes.data(), bytes.size());
+            sum.update(bytes.data(), bytes.size());
+            offset += bytes.size();
+        }
+    };
+
+    bool write_file(const fs::path& p, const string& content)
+    {
+        std::ofstream out(p, std::ios::binary);
+        if (!out) { return false; }
+        out.write(content.data(), content.size());
+        out.close();
+        return static_cast<bool>(out);
+    }
+
+    bool write_repository(const fs::path& root, const fs::path& git_dir, const commit_settings& settings,
+                          string& error, progress_reporter* progress);
+}
+
+bool git_init_repository(const fs::path& root, string& error, progress_reporter* progress)
+{
+    const fs::path git_dir = root / ".git";
+    if (fs::exists(git_dir))
+    {
+        error = "template already contains a .git directory";
+        return false;
+    }
+    commit_settings settings;
+    if (!read_commit_settings(settings, error))
+    {
+        return false;
+    }
+    bool ok = write_repository(root, git_dir, settings, error, progress);
+    if (progress) { progress->stop(); }
+    if (ok)
+    {
+        return true;
+    }
+    // never leave a half written repository behind
+    std::error_code ignored;
+    fs::remove_all(git_dir, ignored);
+    return false;
+}
+
+namespace {
+bool write_repository(const fs::path& root, const fs::path& git_dir, const commit_settings& settings,
+                      string& error, progress_reporter* progress)
+{
+    try
+    {
+
+        // collect every file the template produced
+        vector<file_entry> files;
+        for (auto it = fs::recursive_directory_iterator(root); it != fs::recursive_directory_iterator(); ++it)
+        {
+            const fs::directory_entry& entry = *it;
+            fs::file_status status = entry.symlink_status();
+            file_entry f;
+            if (fs::is_symlink(status))
+            {
+                f.mode = 0120000;
+            }
+            else if (fs::is_regular_file(status))
+            {
+                bool exec = (status.permissions() & fs::perms::owner_exec) != fs::perms::none;
+                f.mode = exec ? 0100755 : 0100644;
+            }
+            else
+            {
+                continue;
+            }
+            f.full = entry.path();
+            if (f.mode != 0120000)
+            {
+                std::error_code ec;
+                f.bytes    = entry.file_size(ec);
+                f.streamed = !ec && f.bytes > STREAM_THRESHOLD;
+            }
+            f.path = entry.path().lexically_relative(root).generic_string();
+            files.push_back(std::move(f));
+        }
+        sort(files.begin(), files.end(), [](const file_entry& a, const file_entry& b) { return a.path < b.path; });
+        if (progress)
+        {
+            // sizes are known from the walk, so MB and ETA follow bytes read
+            uint64_t bytes_total = 0;
+            for (const auto& f : files) { bytes_total += f.bytes; }
+            progress->start("git", bytes_total, files.size());
+        }
+
+        // every directory holding a file becomes a tree, plus the root
+        map<string, vector<tree_item>> trees;
+        trees[""];
+        for (auto& f : files)
+        {
+            for (string dir = parent_of(f.path); !dir.empty(); dir = parent_of(dir)) { trees[dir]; }
+        }
+
+        fs::create_directories(git_dir / "objects" / "pack");
+        fs::create_directories(git_dir / "objects" / "info");
+        fs::create_directories(git_dir / "refs" / "heads");
+        fs::create_directories(git_dir / "refs" / "tags");
+
+        pack_writer pack;
+        const fs::path tmp_pack = git_dir / "objects" / "pack" / "tmp_pack";
+        pack.out.open(tmp_pack, std::ios::binary);
+        if (!pack.out)
+        {
+            error = "could not create " + tmp_pack.string();
+            return false;
+        }
+        // one object per file, tree and the commit; identical contents are
+        // only packed once, in which case the count is patched afterwards
+        const uint32_t planned = static_cast<uint32_t>(files.size() + trees.size() + 1);
+        string header = "PACK";
+        put_be32(header, 2);
+        put_be32(header, planned);
+        pack.write(header);
+
+        vector<pack_entry> entries;
+        entries.reserve(planned);
+        set<object_id> packed;
+        auto add_object = [&](const object_id& id, const string& record) {
+            if (!packed.insert(id).second) { return; }
+            uint32_t crc = crc32_update(0, reinterpret_cast<const unsigned char*>(record.data()), record.size());
+            entries.push_back({id, crc, pack.offset});
+            pack.write(record);
+        };
+
+        // blobs: workers read and hash ahead, the pack is written in path
+        // order; what they hold ahead of the writer is bounded by bytes
+        const size_t workers = max(1u, thread::hardware_concurrency());
+        vector<string> records(files.size());
+        vector<char>   ready(files.size(), 0);
+        atomic<size_t> next{0};
+        size_t         written  = 0;
+        uint64_t       in_flight = 0;
+        bool           failed   = false;
+        mutex              lock;
+        condition_variable changed;
+
+        // a loaded blob is held twice: its contents and its pack record
+        auto cost = [&](size_t i) { return files[i].streamed ? 0 : 2 * files[i].bytes; };
+
+        auto hash_blobs = [&]() {
+            for (size_t i = next++; i < files.size(); i = next++)
+            {
+                {
+                    unique_lock<mutex> guard(lock);
+                    changed.wait(guard, [&] { return failed || i == written || in_flight + cost(i) <= WINDOW_BYTES; });
+                    if (failed) { return; }
+                    in_flight += cost(i);
+                }
+                string record;
+                bool ok = false;
+                try
+                {
+                    if (files[i].streamed)
+                    {
+                        ok = hash_streamed(files[i], progress);
+                    }
+                    else
+                    {
+                        string content;
+                        ok = load_file(files[i], content);
+                        // symlinks have no size in the walk, their target only counts as an entry
+                        if (progress) { progress->add(files[i].mode == 0120000 ? 0 : content.size()); }
+                        if (ok)
+                        {
+                            files[i].id = hash_object("blob", content);
+                            record = pack_record(OBJ_BLOB, content);
+                        }
+                    }
+                }
+                catch (const std::exception&)
+                {
+                    ok = false;
+                }
+                {
+                    lock_guard<mutex> guard(lock);
+                    if (!ok && !failed)
+                    {
+                        failed = true;
+                        error  = "could not read " + files[i].full.string();
+                    }
+                    records[i] = std::move(record);
+                    ready[i]   = 1;
+                }
+                changed.notify_all();
+            }
+        };
+        vector<thread> pool;
+        for (size_t t = 0; t < min(workers, max<size_t>(files.size(), 1)); t++) { pool.emplace_back(hash_blobs); }
+
+        for (size_t i = 0; i < files.size(); i++)
+        {
+            string record;
+            {
+                unique_lock<mutex> guard(lock);
+                changed.wait(guard, [&] { return failed || ready[i]; });
+                if (failed) { break; }
+                record = std::move(records[i]);
+            }
+            bool ok = true;
+            if (!files[i].streamed)
+            {
+                add_object(files[i].id, record);
+            }
+            else if (packed.insert(files[i].id).second)
+            {
+                uint64_t offset = pack.offset;
+                uint32_t crc    = 0;
+                ok = pack.copy_blob(files[i], crc);
+                entries.push_back({files[i].id, crc, offset});
+            }
+            record = string();
+            {
+                lock_guard<mutex> guard(lock);
+                if (!ok && !failed)
+                {
+                    failed = true;
+                    error  = "could not read " + files[i].full.string();
+                }
+                in_flight -= cost(i);
+                written++;
+            }
+            changed.notify_all();
+            if (!ok) { break; }
+        }
+        for (auto& t : pool) { t.join(); }
+        if (failed)
+        {
+            pack.out.close();
+            return false;
+        }
+
+        for (auto& f : files)
+        {
+            size_t slash = f.path.rfind('/');
+            trees[parent_of(f.path)].push_back({slash == string::npos ? f.path : f.path.substr(slash + 1), f.mode, f.id});
+        }
+
+        // trees, deepest first so each parent sees its children's ids
+        vector<string> dirs;
+        for (auto& pair : trees) { dirs.push_back(pair.first); }
+        auto depth = [](const string& d) { return d.empty() ? 0 : 1 + count(d.begin(), d.end(), '/'); };
+        stable_sort(dirs.begin(), dirs.end(), [&](const string& a, const string& b) { return depth(a) > depth(b); });
+
+        object_id root_tree{};
+        for (auto& dir : dirs)
+        {
+            vector<tree_item>& items = trees[dir];
+            sort(items.begin(), items.end(), tree_order);
+            string body;
+            for (auto& item : items)
+            {
+                body += mode_string(item.mode) + " " + item.name;
+                body += '\0';
+                body.append(reinterpret_cast<const char*>(item.id.data()), item.id.size());
+            }
+            object_id id = hash_object("tree", body);
+            add_object(id, pack_record(OBJ_TREE, body));
+            if (dir.empty())
+            {
+                root_tree = id;
+            }
+            else
+            {
+                size_t slash = dir.rfind('/');
+                trees[parent_of(dir)].push_back({slash == string::npos ? dir : dir.substr(slash + 1), 040000, id});
+            }
+        }
+
+        // the initial commit
+        string stamp   = git_timestamp() + "\n";
+        string commit  = "tree " + to_hex(root_tree) + "\n" +
+                         "author " + settings.author + stamp +
+                         "committer " + settings.committer + stamp +
+                         "\nInitial commit\n";
+        object_id commit_id = hash_object("commit", commit);
+        add_object(commit_id, pack_record(OBJ_COMMIT, commit));
+
+        object_id pack_id = pack.sum.digest();
+        if (entries.size() != planned)
+        {
+            // duplicates were skipped: fix the count and checksum the pack again
+            pack.out.seekp(8);
+            string count;
+            put_be32(count, static_cast<uint32_t>(entries.size()));
+            pack.out.write(count.data(), count.size());
+            pack.out.close();
+
+            std::ifstream in(tmp_pack, std::ios::binary);
+            sha1 sum;
+            vector<char> chunk(1 << 20);
+            while (in.read(chunk.data(), chunk.size()) || in.gcount() > 0)
+            {
+                sum.update(chunk.data(), static_cast<size_t>(in.gcount()));
+            }
+            pack_id = sum.digest();
+            pack.out.open(tmp_pack, std::ios::binary | std::ios::in | std::ios::out | std::ios::ate);
+        }
+        pack.out.write(reinterpret_cast<const char*>(pack_id.data()), pack_id.size());
+        pack.out.close();
+        if (!pack.out)
+        {
+            error = "could not write " + tmp_pack.string();
+            return false;
+        }
+
+        // pack index (v2): fanout, sorted ids, crcs, offsets
+        sort(entries.begin(), entries.end(), [](const pack_entry& a, const pack_entry& b) { return a.id < b.id; });
+        string idx = "\377tOc";
+        put_be32(idx, 2);
+        size_t at = 0;
+        for (int byte = 0; byte < 256; byte++)
+        {
+            while (at < entries.size() && entries[at].id[0] <= byte) { at++; }
+            put_be32(idx, static_cast<uint32_t>(at));
+        }
+        for (auto& e : entries) { idx.append(reinterpret_cast<const char*>(e.id.data()), e.id.size()); }
+        for (auto& e : entries) { put_be32(idx, e.crc); }
+        string large;
+        uint32_t large_count = 0;
+        for (auto& e : entries)
+        {
+            if (e.offset < 0x80000000ULL)
+            {
+                put_be32(idx, static_cast<uint32_t>(e.offset));
+                continue;
+            }
+            put_be32(idx, 0x80000000u | large_count++);
+            put_be32(large, static_cast<uint32_t>(e.offset >> 32));
+            put_be32(large, static_cast<uint32_t>(e.offset));
+        }
+        idx += large;
+        idx.append(reinterpret_cast<const char*>(pack_id.data()), pack_id.size());
+        sha1 idx_sum;
+        idx_sum.update(idx.data(), idx.size());
+        object_id idx_id = idx_sum.digest();
+        idx.append(reinterpret_cast<const char*>(idx_id.data()), idx_id.size());
+
+        const fs::path pack_base = git_dir / "objects" / "pack" / ("pack-" + to_hex(pack_id));
+        if (!write_file(pack_base.string() + ".idx", idx))
+        {
+            error = "could not write pack index";
+            return false;
+        }
+        fs::rename(tmp_pack, pack_base.string() + ".pack");
+
+        // index (v2) so the work tree shows up as clean
+        string index = "DIRC";
+        put_be32(index, 2);
+        put_be32(index, static_cast<uint32_t>(files.size()));
+        for (auto& f : files)
+        {
+            size_t start = index.size();
+            for (int i = 0; i < 6; i++) { put_be32(index, f.stat_fields[i]); }
+            put_be32(index, f.mode);
+            put_be32(index, f.stat_fields[6]);
+            put_be32(index, f.stat_fields[7]);
+            put_be32(index, f.size);
+            index.append(reinterpret_cast<const char*>(f.id.data()), f.id.size());
+            put_be16(index, static_cast<uint16_t>(min<size_t>(f.path.size(), 0xfff)));
+            index += f.path;
+            size_t len = index.size() - start;
+            index.append(8 - len % 8, '\0');
+        }
+        sha1 index_sum;
+        index_sum.update(index.data(), index.size());
+        object_id index_id = index_sum.digest();
+        index.append(reinterpret_cast<const char*>(index_id.data()), index_id.size());
+
+        #ifdef _WIN32
+            const string filemode = "false";
+        #else
+            const string filemode = "true";
+        #endif
+        fs::create_directories((git_dir / "refs" / "heads" / settings.branch).parent_path());
+        bool ok = write_file(git_dir / "index", index) &&
+                  write_file(git_dir / "refs" / "heads" / settings.branch, to_hex(commit_id) + "\n") &&
+                  write_file(git_dir / "HEAD", "ref: refs/heads/" + settings.branch + "\n") &&
+                  write_file(git_dir / "description", "Unnamed repository; edit this file 'description' to name the repository.\n") &&
+                  write_file(git_dir / "config",
+                             "[core]\n"
+                             "\trepositoryformatversion = 0\n"
+                             "\tfilemode = " + filemode + "\n"
+                             "\tbare = false\n"
+                             "\tlogallrefupdates = true\n");
+        if (!ok)
+        {
+            error = "could not write repository metadata";
+            return false;
+        }
+    }
+    catch (const fs::filesystem_error& e)
+    {
+        error = e.what();
+        return false;
+    }
+    return true;
+}
+}
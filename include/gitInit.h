@@ -0,0 +1,33 @@
+#pragma once
+
+/**
+BRIEF:
+    Creates a git repository with an initial commit for a freshly
+    scaffolded project, without running git. This is a walk of the
+    tree after extraction: every file is read back from disk, so it
+    saves spawning git but not the I/O of `git add -A`. Blobs are
+    hashed by a pool of workers and streamed into a single packfile,
+    then the trees, the commit, the pack index and the git index are
+    written so `git status` is clean and `git fsck` accepts the result.
+
+NOTES:
+    Objects are stored with zlib "stored" blocks (no compression),
+    which git reads like any other zlib stream; `git gc` repacks them.
+    Small blobs are loaded whole, within a byte budget ahead of the
+    pack writer; large ones are hashed and copied in chunks.
+    Author, committer and branch follow git commit / git init: the
+    GIT_AUTHOR_* / GIT_COMMITTER_* variables, then author.*,
+    committer.* and user.* from the global and XDG git config (or
+    $GIT_CONFIG_GLOBAL), and init.defaultBranch (default master).
+    Without a name and email it fails before writing anything.
+
+*/
+#include "progress.h"
+#include <filesystem>
+#include <string>
+using namespace std;
+namespace fs = filesystem;
+
+// writes root/.git with every file under root in one initial commit,
+// on failure returns false and describes the problem in error
+bool git_init_repository(const fs::path& root, string& error, progress_reporter* progress = nullptr);
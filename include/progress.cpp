@@ -0,0 +1,203 @@
+#include "progress.h"
+#include <cstdio>
+#include <fstream>
+#include <vector>
+#ifdef _WIN32
+    #include <io.h>
+    #define isatty _isatty
+    #define fileno _fileno
+#else
+    #include <unistd.h>
+#endif
+
+namespace {
+    // refresh caps, a terminal line is cheap to redraw, log lines are not
+    const chrono::milliseconds TTY_INTERVAL(100);
+    const chrono::milliseconds JSON_INTERVAL(1000);
+
+    uint64_t read_le(const unsigned char* p, int n)
+    {
+        uint64_t v = 0;
+        for (int i = n - 1; i >= 0; i--) { v = (v << 8) | p[i]; }
+        return v;
+    }
+
+    string label(const string& phase)
+    {
+        if (phase == "extract") { return "Extracting Template"; }
+        if (phase == "git")     { return "Initializing Git Repository"; }
+        return phase;
+    }
+}
+
+progress_reporter::progress_reporter(const string& mode)
+{
+    if (mode == "json")      { style = JSON; }
+    else if (mode == "tty")  { style = TTY; }
+    else if (mode == "none") { style = NONE; }
+    else                     { style = isatty(fileno(stderr)) ? TTY : NONE; }
+}
+
+progress_reporter::~progress_reporter()
+{
+    stop();
+}
+
+void progress_reporter::start(const string& phase, uint64_t bytes_total, uint64_t entries_total)
+{
+    stop();
+    this->phase         = phase;
+    this->bytes_total   = bytes_total;
+    this->entries_total = entries_total;
+    bytes_done.store(0);
+    entries_done.store(0);
+    started = chrono::steady_clock::now();
+    if (!enabled()) { return; }
+    running = true;
+    worker  = thread(&progress_reporter::loop, this);
+}
+
+void progress_reporter::stop()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        if (!running) { return; }
+        running = false;
+    }
+    wake.notify_all();
+    worker.join();
+    render(true);
+}
+
+void progress_reporter::loop()
+{
+    const chrono::milliseconds interval = style == TTY ? TTY_INTERVAL : JSON_INTERVAL;
+    unique_lock<mutex> guard(lock);
+    while (running)
+    {
+        if (wake.wait_for(guard, interval, [this] { return !running; })) { break; }
+        render(false);
+    }
+}
+
+void progress_reporter::render(bool final)
+{
+    const uint64_t bytes   = bytes_done.load(memory_order_relaxed);
+    const uint64_t entries = entries_done.load(memory_order_relaxed);
+    const double   elapsed = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    const double   mb      = bytes / 1048576.0;
+    const double   rate    = elapsed > 0 ? mb / elapsed : 0;
+
+    // prefer bytes for the estimate, entries when sizes are unknown
+    double done = 0;
+    if (bytes_total)        { done = double(bytes) / bytes_total; }
+    else if (entries_total) { done = double(entries) / entries_total; }
+    const double eta = done > 0 ? elapsed * (1 - done) / done : -1;
+
+    if (style == JSON)
+    {
+        char eta_text[32] = "null";
+        if (eta >= 0) { snprintf(eta_text, sizeof(eta_text), "%.2f", final ? 0.0 : eta); }
+        fprintf(stderr,
+            "{\"phase\":\"%s\",\"entries\":%llu,\"entries_total\":%llu,\"bytes\":%llu,\"bytes_total\":%llu,"
+            "\"mb_per_s\":%.2f,\"elapsed_s\":%.2f,\"eta_s\":%s,\"done\":%s}\n",
+            phase.c_str(),
+            (unsigned long long)entries, (unsigned long long)entries_total,
+            (unsigned long long)bytes, (unsigned long long)bytes_total,
+            rate, elapsed,
+            eta_text,
+            final ? "true" : "false");
+    }
+    else if (final)
+    {
+        // clear the line so the [PROC] result takes its place
+        fprintf(stderr, "\r\033[K");
+    }
+    else
+    {
+        fprintf(stderr, "\r\033[K[PROC]%s... %llu/%llu entries  %.1f",
+            label(phase).c_str(),
+            (unsigned long long)entries, (unsigned long long)entries_total, mb);
+        if (bytes_total) { fprintf(stderr, "/%.1f", bytes_total / 1048576.0); }
+        fprintf(stderr, " MB  %.1f MB/s", rate);
+        if (eta >= 0) { fprintf(stderr, "  ETA %.0fs", eta); }
+    }
+    fflush(stderr);
+}
+
+// --------------------------------------------------------
+// reads the zip central directory for entry sizes, so extraction
+// progress can be reported in bytes without touching the data
+bool progress_reporter::load_zip_totals(const fs::path& zip_file)
+{
+    zip_sizes.clear();
+    zip_bytes = 0;
+    std::ifstream in(zip_file, std::ios::binary | std::ios::ate);
+    if (!in) { return false; }
+    const uint64_t file_size = static_cast<uint64_t>(in.tellg());
+
+    // end of central directory record sits in the last 64KB + 22 bytes
+    const uint64_t tail_size = min<uint64_t>(file_size, 65557);
+    vector<unsigned char> tail(tail_size);
+    in.seekg(file_size - tail_size);
+    in.read(reinterpret_cast<char*>(tail.data()), tail_size);
+    if (!in || tail_size < 22) { return false; }
+
+    int64_t eocd = -1;
+    for (int64_t i = tail_size - 22; i >= 0; i--)
+    {
+        if (read_le(&tail[i], 4) == 0x06054b50) { eocd = i; break; }
+    }
+    if (eocd < 0) { return false; }
+    uint64_t count     = read_le(&tail[eocd + 10], 2);
+    uint64_t cd_size   = read_le(&tail[eocd + 12], 4);
+    uint64_t cd_offset = read_le(&tail[eocd + 16], 4);
+
+    // zip64 archives keep the real values in a separate record
+    if (eocd >= 20 && read_le(&tail[eocd - 20], 4) == 0x07064b50)
+    {
+        unsigned char record[56];
+        in.seekg(read_le(&tail[eocd - 12], 8));
+        in.read(reinterpret_cast<char*>(record), sizeof(record));
+        if (!in || read_le(record, 4) != 0x06064b50) { return false; }
+        count     = read_le(record + 32, 8);
+        cd_size   = read_le(record + 40, 8);
+        cd_offset = read_le(record + 48, 8);
+    }
+    if (cd_offset + cd_size > file_size) { return false; }
+
+    vector<unsigned char> cd(cd_size);
+    in.seekg(cd_offset);
+    in.read(reinterpret_cast<char*>(cd.data()), cd_size);
+    if (!in) { return false; }
+
+    zip_sizes.reserve(count);
+    size_t pos = 0;
+    while (pos + 46 <= cd.size() && read_le(&cd[pos], 4) == 0x02014b50)
+    {
+        uint64_t size      = read_le(&cd[pos + 24], 4);
+        size_t   name_len  = read_le(&cd[pos + 28], 2);
+        size_t   extra_len = read_le(&cd[pos + 30], 2);
+        size_t   note_len  = read_le(&cd[pos + 32], 2);
+        if (pos + 46 + name_len + extra_len > cd.size()) { return false; }
+        string name(reinterpret_cast<const char*>(&cd[pos + 46]), name_len);
+
+        // uncompressed size is the first field of the zip64 extra block
+        for (size_t x = pos + 46 + name_len; size == 0xFFFFFFFF && x + 4 <= pos + 46 + name_len + extra_len;)
+        {
+            size_t len = read_le(&cd[x + 2], 2);
+            if (read_le(&cd[x], 2) == 0x0001 && len >= 8) { size = read_le(&cd[x + 4], 8); }
+            x += 4 + len;
+        }
+        zip_sizes[name] = size;
+        zip_bytes += size;
+        pos += 46 + name_len + extra_len + note_len;
+    }
+    return true;
+}
+
+void progress_reporter::entry_done(const string& name)
+{
+    auto hit = zip_sizes.find(name);
+    add(hit == zip_sizes.end() ? 0 : hit->second);
+}
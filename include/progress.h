@@ -0,0 +1,76 @@
+#pragma once
+
+/**
+BRIEF:
+    Live progress for long running steps (extraction, git init).
+    Producers only bump relaxed atomic counters; a reporter thread
+    samples them at a capped rate and renders either a single
+    refreshing line on a terminal or one JSON object per line
+    (--progress=json) on stderr, so stdout keeps the [PROC] lines.
+
+NOTES:
+    Extraction runs in the system unzip / tar, so its counters are fed
+    from the extractor's per-entry listing (entry_done), credited when
+    a line is printed. Names the extractor escapes or truncates do not
+    match the central directory and count as 0 bytes. git init feeds
+    its counters from the hashing workers as files are read.
+
+*/
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+using namespace std;
+namespace fs = filesystem;
+
+class progress_reporter
+{
+public:
+//-------------------------------------------------------
+atomic<uint64_t> bytes_done{0};
+atomic<uint64_t> entries_done{0};
+//-------------------------------------------------------
+// mode is one of auto, tty, json, none (auto picks tty only on a terminal)
+progress_reporter(const string& mode);
+~progress_reporter();
+
+bool    enabled() const { return style != NONE; }
+void    start(const string& phase, uint64_t bytes_total, uint64_t entries_total);
+void    stop();
+
+// called from any thread, never blocks
+void    add(uint64_t bytes, uint64_t entries = 1)
+{
+    bytes_done.fetch_add(bytes, memory_order_relaxed);
+    entries_done.fetch_add(entries, memory_order_relaxed);
+}
+
+// zip aware helpers used while extracting, entry_done takes a name
+// from the extractor's listing and credits its central directory size
+bool    load_zip_totals(const fs::path& zip_file);
+void    entry_done(const string& name);
+uint64_t zip_bytes_total() const   { return zip_bytes; }
+uint64_t zip_entries_total() const { return zip_sizes.size(); }
+
+private:
+enum output_style { NONE, TTY, JSON };
+output_style            style;
+string                  phase;
+uint64_t                bytes_total   = 0;
+uint64_t                entries_total = 0;
+chrono::steady_clock::time_point started;
+thread                  worker;
+mutex                   lock;
+condition_variable      wake;
+bool                    running = false;
+unordered_map<string, uint64_t> zip_sizes;  // entry name -> uncompressed size
+uint64_t                zip_bytes = 0;
+
+void    loop();
+void    render(bool final);
+};
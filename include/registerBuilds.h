@@ -11,6 +11,12 @@
  * 1. Create your template zip file
  * 2. Convert it to .h: xxd -i your-template.zip > your-template.h
  * 3. Add a REGISTER_BUILD line below
+ *
+ * To add another version of an existing build as a delta:
+ * 1. Register the base zip with REGISTER_BUILD_VERSION
+ * 2. Encode the new version: br -MD base.zip new.zip new.delta
+ * 3. Convert it to .h: xxd -i new.delta > new.h
+ * 4. Add a REGISTER_BUILD_DELTA line below
  */
 
 #include "buildRegistry.h"
@@ -26,4 +32,8 @@
 
 REGISTER_BUILD("test-build", test_build_1, "../templates/test_build_1.h")
 // Add more builds here as you create them:
-// REGISTER_BUILD("another-build", "templates/another-build.h")
\ No newline at end of file
+// REGISTER_BUILD("another-build", "templates/another-build.h")
+//
+// Versioned builds, selected with -TN name@version:
+// REGISTER_BUILD_VERSION("spring-boot", "2", spring_boot_2, "../templates/spring_boot_2.h")
+// REGISTER_BUILD_DELTA("spring-boot", "3", "2", spring_boot_3, "../templates/spring_boot_3.h")
\ No newline at end of file
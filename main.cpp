@@ -17,6 +17,7 @@
 #endif
 
 #include "include/boilr.h"
+#include "include/durability.h"
 
 using namespace std;
 
@@ -93,6 +94,49 @@ int handle_commands(int argc, char* argv[])
             cout << "[ERROR] invalid number of command args: " << argv[i] << endl;
             exit(-1);
         }
+        // handle creating a git repository for the project
+        else if (strcmp(argv[i], "-G") == 0 || strcmp(argv[i], "--git") == 0) {
+            user_config.git_init = true;
+            continue;
+        }
+        // handle selecting how progress is reported
+        else if (strncmp(argv[i], "--progress=", 11) == 0) {
+            string mode = argv[i] + 11;
+            if (mode == "auto" || mode == "tty" || mode == "json" || mode == "none")
+            {
+                user_config.progress_mode = mode;
+                continue;
+            }
+            cout << "[ERROR] invalid progress mode: " << mode << endl;
+            exit(-1);
+        }
+        // handle selecting the durability policy
+        else if (strcmp(argv[i], "--sync") == 0 || strncmp(argv[i], "--sync=", 7) == 0) {
+            string policy;
+            if (argv[i][6] == '=')    { policy = argv[i] + 7; }
+            else if (i+1 < argc)      { policy = argv[++i]; }
+            else
+            {
+                cout << "[ERROR] invalid number of command args: " << argv[i] << endl;
+                exit(-1);
+            }
+            if (!valid_sync_policy(policy))
+            {
+                cout << "[ERROR] invalid sync policy: " << policy << endl;
+                exit(-1);
+            }
+            user_config.sync_policy = policy;
+            continue;
+        }
+        // handle encoding a template version as a delta
+        else if (strcmp(argv[i], "-MD") == 0 || strcmp(argv[i], "-MAKE-DELTA") == 0) {
+            if (i+3 < argc)
+            {
+                exit(br.make_delta(argv[i+1], argv[i+2], argv[i+3]) ? 0 : -1);
+            }
+            cout << "[ERROR] invalid number of command args: " << argv[i] << endl;
+            exit(-1);
+        }
     }
     // Initialize terminal colors for Windows
     #ifdef _WIN32
@@ -123,4 +167,7 @@ void config_to_string(USER_CONFIG config)
     cout << "TEMPLATE NAME: " << config.template_name << endl;
     cout << "PROJECT NAME: " << config.project_name << endl;
     cout << "DESTINATION: " << config.project_destination << endl;
+    cout << "GIT INIT: " << (config.git_init ? "yes" : "no") << endl;
+    cout << "PROGRESS: " << config.progress_mode << endl;
+    cout << "SYNC: " << config.sync_policy << endl;
 }
@@ -0,0 +1,511 @@
+'''
+
+Concurrency and scale stress run for br
+
+1. generates large synthetic templates (wide, deep and big) as zip files
+2. copies the source tree and embeds the templates with .incbin, since
+   multi-GB arrays are far beyond what xxd -i headers can compile; the
+   length is a 64-bit symbol, so templates of 4 GiB and more keep their size
+3. builds that copy with cmake
+4. runs many scaffolds at once, into separate destinations and into one
+   shared destination
+5. checks every project tree, that no .zip or staging folder is left over,
+   and that wall time and peak RSS stay under ceilings scaled from each
+   scenario's input: seconds per entry and per MB over all jobs (with a
+   floor), and the scenario's own template size plus a small RSS slack
+6. scaffolds the wide and big templates with --git and checks the
+   repository with git fsck --strict, an empty git status --porcelain and
+   the author given through GIT_AUTHOR_NAME / GIT_AUTHOR_EMAIL;
+   the big template's blobs are over the streaming threshold, so the
+   streamed pack path is covered
+7. derives a second version of the wide template, encodes it with br -MD,
+   embeds wide@1 (REGISTER_BUILD_VERSION) and the delta
+   (REGISTER_BUILD_DELTA), and checks the tree scaffolded from wide@2
+8. benchmarks the cost of optional instrumentation (--progress) and of
+   each durability policy (--sync), with interleaved single runs and medians;
+   --max-progress-cpu-overhead gates the progress comparison on median CPU
+   time (br plus the unzip it waits for), which is far steadier than wall
+   time. It cannot prove the 1% overhead budget: a 20000 entry scaffold's
+   CPU varies by about 25% run to run from filesystem work alone, so the
+   gate catches gross regressions (output or locking per entry), while br's
+   own listing parse profiles at about 0.02s of CPU per 20000 entries
+
+Exits non zero when any check fails. CMake registers a small run as the
+stress_scaffold CTest test, and the full size run as stress_scaffold_large
+when configured with -DBR_STRESS_LARGE=ON.
+
+Usage: python3 stress_scaffold.py [--entries 100000] [--depth 64] [--big-mb 2048] [--jobs 8]
+
+'''
+import argparse
+import concurrent.futures
+import hashlib
+import os
+import platform
+import random
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+import zipfile
+
+project_root = os.path.abspath(os.path.join(os.path.dirname(__file__), "../../.."))
+
+# big template files are written in chunks of this size
+CHUNK = 1 << 20
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description="stress br with large templates and concurrent scaffolds")
+    parser.add_argument("--entries", type=int, default=100000, help="files in the wide template")
+    parser.add_argument("--depth", type=int, default=64, help="nesting depth of the deep template")
+    parser.add_argument("--big-mb", type=int, default=2048, help="total size of the big template in MB")
+    parser.add_argument("--jobs", type=int, default=8, help="scaffolds run at the same time")
+    parser.add_argument("--seconds-per-entry", type=float, default=0.001,
+                        help="wall time allowed per extracted file, summed over all jobs of a scenario")
+    parser.add_argument("--seconds-per-mb", type=float, default=0.06,
+                        help="wall time allowed per MB extracted, summed over all jobs of a scenario")
+    parser.add_argument("--min-seconds", type=float, default=5, help="wall time ceiling floor per scenario")
+    parser.add_argument("--rss-slack-mb", type=int, default=32,
+                        help="peak RSS ceiling above the scenario's embedded template")
+    parser.add_argument("--bench-rounds", type=int, default=5, help="runs per variant in the benchmarks")
+    parser.add_argument("--progress-rounds", type=int, default=15,
+                        help="runs per variant in the progress overhead benchmark")
+    parser.add_argument("--max-progress-cpu-overhead", type=float,
+                        help="fail when --progress=json costs more than this percent of median CPU time; "
+                             "run-to-run noise is around 25%%, so keep it at or above that")
+    parser.add_argument("--work-dir", help="where to build and scaffold (default: a temp dir)")
+    parser.add_argument("--keep", action="store_true", help="keep the work dir afterwards")
+    return parser.parse_args()
+
+
+# ---------------------------------------------------------------
+# synthetic templates, each returns {relative path: (size, sha256)}
+def write_wide(zip_path, entries, version=1):
+    # version 2 edits, drops and adds a few entries, as a template update
+    # would; both carry one fixed timestamp so only real edits differ
+    files = []
+    for i in range(entries):
+        if version == 2 and i % 101 == 50:
+            continue
+        data = ("entry %d%s\n" % (i, " v2" if version == 2 and i % 97 == 0 else "")).encode()
+        files.append(("d%04d/f%06d.txt" % (i // 1000, i), data))
+    if version == 2:
+        files += [("added/f%06d.txt" % i, ("added %d\n" % i).encode()) for i in range(50)]
+    manifest = {}
+    with zipfile.ZipFile(zip_path, "w", zipfile.ZIP_STORED) as z:
+        for rel, data in files:
+            z.writestr(zipfile.ZipInfo("stress-wide/" + rel, date_time=(2024, 1, 1, 0, 0, 0)), data)
+            manifest[rel] = (len(data), hashlib.sha256(data).hexdigest())
+    return manifest
+
+
+def write_deep(zip_path, depth):
+    manifest = {}
+    with zipfile.ZipFile(zip_path, "w", zipfile.ZIP_DEFLATED) as z:
+        rel_dir = ""
+        for level in range(depth):
+            rel_dir += "level%02d/" % level
+            rel = rel_dir + "file.txt"
+            data = ("depth %d\n" % level).encode() * 64
+            z.writestr("stress-deep/" + rel, data)
+            manifest[rel] = (len(data), hashlib.sha256(data).hexdigest())
+    return manifest
+
+
+def write_big(zip_path, big_mb):
+    manifest = {}
+    rng = random.Random(248)
+    block = rng.randbytes(CHUNK)
+    files = max(1, big_mb // 256)
+    per_file = big_mb // files
+    with zipfile.ZipFile(zip_path, "w", zipfile.ZIP_STORED, allowZip64=True) as z:
+        for n in range(files):
+            rel = "blob%02d.bin" % n
+            sha = hashlib.sha256()
+            with z.open("stress-big/" + rel, "w", force_zip64=True) as out:
+                for c in range(per_file):
+                    # vary each chunk so the file is not one repeated block
+                    chunk = c.to_bytes(8, "little") + block[8:]
+                    out.write(chunk)
+                    sha.update(chunk)
+            manifest[rel] = (per_file * CHUNK, sha.hexdigest())
+    return manifest
+
+
+# ---------------------------------------------------------------
+# build a copy of br with the templates embedded
+def embed_blob(src_dir, base, kind, data_path, registration):
+    # kind is "zip" or "delta", the suffix BUILD_DATA / BUILD_DELTA_DATA expect
+    prefix = "_" if platform.system() == "Darwin" else ""
+    # x86-64 code reaches .data with 32-bit offsets, so blobs of 2 GB and
+    # more go in the large data section placed after everything else
+    large_data = platform.system() == "Linux" and platform.machine() in ("x86_64", "AMD64")
+    blob_section = '.section .ldata,"aw"' if large_data else ".data"
+    symbol = "%s%s_%s" % (prefix, base, kind)
+    with open(os.path.join(src_dir, "templates", base + ".S"), "w") as asm:
+        asm.write(".data\n.balign 8\n.globl %s_len\n%s_len:\n" % (symbol, symbol))
+        asm.write(".quad %d\n" % os.path.getsize(data_path))
+        asm.write("%s\n.balign 16\n" % blob_section)
+        asm.write(".globl %s\n%s:\n" % (symbol, symbol))
+        asm.write('.incbin "%s"\n' % data_path)
+        if platform.system() == "Linux":
+            asm.write('.section .note.GNU-stack,"",@progbits\n')
+    with open(os.path.join(src_dir, "templates", base + ".h"), "w") as header:
+        header.write('extern "C" unsigned char %s_%s[];\n' % (base, kind))
+        header.write('extern "C" const unsigned long long %s_%s_len;\n' % (base, kind))
+    with open(os.path.join(src_dir, "include", "registerBuilds.h"), "a") as register:
+        register.write('\n#include "../templates/%s.h"\n' % base)
+        register.write(registration + "\n")
+    with open(os.path.join(src_dir, "include", "CMakeLists.txt"), "a") as cmake:
+        cmake.write("target_sources(CLI_TOOL PRIVATE ${CMAKE_CURRENT_SOURCE_DIR}/../templates/%s.S)\n" % base)
+
+
+def embed_templates(src_dir, templates, versions):
+    # versions: {name: version} also registers that template as name@version,
+    # the base a delta build is made against
+    with open(os.path.join(src_dir, "include", "CMakeLists.txt"), "a") as cmake:
+        cmake.write("\nenable_language(ASM)\n")
+    for name, zip_path in templates.items():
+        base = "stress_" + name
+        path = "../templates/%s.h" % base
+        registration = 'REGISTER_BUILD("%s", %s, "%s")' % (base, base, path)
+        if name in versions:
+            registration += '\nREGISTER_BUILD_VERSION("%s", "%s", %s, "%s")' % (base, versions[name], base, path)
+        embed_blob(src_dir, base, "zip", zip_path, registration)
+
+
+def embed_delta(src_dir, name, version, base_version, delta_path):
+    base = "stress_%s_%s" % (name, version)
+    embed_blob(src_dir, base, "delta", delta_path,
+               'REGISTER_BUILD_DELTA("stress_%s", "%s", "%s", %s, "../templates/%s.h")'
+               % (name, version, base_version, base, base))
+
+
+def ensure_default_template(src_dir):
+    # the default test build is registered unconditionally, fill it in if it is not checked out
+    header = os.path.join(src_dir, "templates", "test_build_1.h")
+    if os.path.exists(header):
+        return
+    zip_path = os.path.join(src_dir, "templates", "test_build_1.zip")
+    with zipfile.ZipFile(zip_path, "w") as z:
+        z.writestr("test-build/README.md", "test build\n")
+    data = open(zip_path, "rb").read()
+    with open(header, "w") as out:
+        out.write("unsigned char test_build_1_zip[] = {%s};\n" % ",".join(str(b) for b in data))
+        out.write("unsigned int test_build_1_zip_len = %d;\n" % len(data))
+
+
+def build_br(work_dir, templates, versions):
+    src_dir = os.path.join(work_dir, "src")
+    def skip_outputs(directory, names):
+        # build folders and release binaries only live at the top level
+        if os.path.abspath(directory) != project_root:
+            return [n for n in names if n == "__pycache__"]
+        return [n for n in names if n in (".git", "_gate_build", "releases") or n.startswith("build-")
+                or (n == "build" and os.path.isdir(os.path.join(directory, n)))]
+
+    shutil.copytree(project_root, src_dir, ignore=skip_outputs)
+    ensure_default_template(src_dir)
+    embed_templates(src_dir, templates, versions)
+    build_dir = os.path.join(work_dir, "build")
+    subprocess.run(["cmake", "-S", src_dir, "-B", build_dir, "-DCMAKE_BUILD_TYPE=Release"],
+                   check=True, stdout=subprocess.DEVNULL)
+    return rebuild_br(work_dir)
+
+
+def rebuild_br(work_dir):
+    build_dir = os.path.join(work_dir, "build")
+    subprocess.run(["cmake", "--build", build_dir, "-j", str(os.cpu_count() or 2)],
+                   check=True, stdout=subprocess.DEVNULL)
+    return os.path.join(build_dir, "br")
+
+
+def add_wide_delta(br, work_dir, template_dir, base_zip, entries):
+    # encodes wide version 2 against the embedded wide@1 with br -MD and
+    # rebuilds br with it registered as stress_wide@2
+    target_zip = os.path.join(template_dir, "stress_wide_2.zip")
+    manifest = write_wide(target_zip, entries, version=2)
+    delta_path = os.path.join(template_dir, "stress_wide_2.delta")
+    subprocess.run([br, "-MD", base_zip, target_zip, delta_path], check=True, stdout=subprocess.DEVNULL)
+    embed_delta(os.path.join(work_dir, "src"), "wide", "2", "1", delta_path)
+    return rebuild_br(work_dir), manifest, os.path.getsize(delta_path), os.path.getsize(target_zip)
+
+
+# ---------------------------------------------------------------
+# checks
+def check_project(project_dir, manifest, full_hash, skip=()):
+    found = {}
+    for root, dirs, names in os.walk(project_dir):
+        if root == project_dir:
+            dirs[:] = [d for d in dirs if d not in skip]
+        for n in names:
+            path = os.path.join(root, n)
+            found[os.path.relpath(path, project_dir).replace(os.sep, "/")] = path
+    if set(found) != set(manifest):
+        missing = len(set(manifest) - set(found))
+        extra = len(set(found) - set(manifest))
+        return "tree mismatch (%d missing, %d unexpected)" % (missing, extra)
+    for i, (rel, (size, sha)) in enumerate(sorted(manifest.items())):
+        path = found[rel]
+        if os.path.getsize(path) != size:
+            return "size mismatch: " + rel
+        # hash everything once, then a sample for the other copies
+        if full_hash or i % 97 == 0:
+            h = hashlib.sha256()
+            with open(path, "rb") as f:
+                for chunk in iter(lambda: f.read(CHUNK), b""):
+                    h.update(chunk)
+            if h.hexdigest() != sha:
+                return "content mismatch: " + rel
+    return None
+
+
+def check_debris(dest_dir, expected):
+    leftovers = sorted(set(os.listdir(dest_dir)) - set(expected))
+    if leftovers:
+        return "leftover debris: " + ", ".join(leftovers[:5])
+    return None
+
+
+def rss_mb(usage):
+    # bytes on macOS, KB elsewhere
+    return usage.ru_maxrss / (1 << 20) if platform.system() == "Darwin" else usage.ru_maxrss / 1024
+
+
+def launch(log_path, command):
+    # runs one scaffold from this small fresh process: on Linux a child's
+    # ru_maxrss starts at its parent's RSS, which would be the whole harness
+    with open(log_path, "wb") as log:
+        proc = subprocess.Popen(command, stdout=log, stderr=subprocess.STDOUT)
+        _, status, usage = os.wait4(proc.pid, 0)
+    print(os.waitstatus_to_exitcode(status), rss_mb(usage), usage.ru_utime + usage.ru_stime)
+    return 0
+
+
+def run_scaffolds(br, template, dests, names, log_dir, extra_args=(), env=None):
+    os.makedirs(log_dir, exist_ok=True)
+
+    def scaffold(args):
+        dest, name = args
+        os.makedirs(dest, exist_ok=True)
+        log_path = os.path.join(log_dir, name + ".log")
+        command = [br, "-TN", template, "-N", name, "-D", dest] + list(extra_args)
+        result = subprocess.run([sys.executable, os.path.abspath(__file__), "--launch", log_path, "--"] + command,
+                                stdout=subprocess.PIPE, check=True, env=env)
+        code, rss, cpu = result.stdout.split()
+        return int(code), float(rss), float(cpu), log_path
+
+    start = time.monotonic()
+    with concurrent.futures.ThreadPoolExecutor(max_workers=len(names)) as pool:
+        results = list(pool.map(scaffold, zip(dests, names)))
+    elapsed = time.monotonic() - start
+    failures = [open(log, errors="replace").read()[-300:] for code, _, _, log in results if code != 0]
+    return elapsed, max(r[1] for r in results), sum(r[2] for r in results), failures
+
+
+def compare_variants(br, kind, variants, rounds, scaffold_dir):
+    # single scaffolds, variants interleaved each round so drift hits all of them;
+    # returns every (wall, cpu) sample per variant
+    samples = {name: [] for name in variants}
+    for r in range(rounds):
+        for name, extra_args in variants.items():
+            dest = os.path.join(scaffold_dir, "bench-%s-%d" % (name, r))
+            elapsed, _, cpu, failures = run_scaffolds(br, "stress_" + kind, [dest], ["bench"],
+                                                      os.path.join(scaffold_dir, "logs"), extra_args)
+            shutil.rmtree(dest, ignore_errors=True)
+            if failures:
+                return None
+            samples[name].append((elapsed, cpu))
+    return samples
+
+
+def medians(samples):
+    return {name: (statistics.median(s[0] for s in v), statistics.median(s[1] for s in v))
+            for name, v in samples.items()}
+
+
+def progress_overhead(br, args, scaffold_dir):
+    variants = {"none": ["--progress=none"], "json": ["--progress=json"]}
+    samples = compare_variants(br, "wide", variants, args.progress_rounds, scaffold_dir)
+    if samples is None:
+        print("bench  progress  scaffold failed  FAIL")
+        return False
+    med = medians(samples)
+    base_wall, base_cpu = med["none"]
+    wall, cpu = med["json"]
+    wall_pct = 100 * (wall - base_wall) / base_wall
+    cpu_pct = 100 * (cpu - base_cpu) / base_cpu if base_cpu else 0
+    ok = args.max_progress_cpu_overhead is None or cpu_pct <= args.max_progress_cpu_overhead
+    print("bench  progress  none %.2fs  json %.2fs  overhead wall %+.2f%%  cpu %+.2f%%  %s"
+          % (base_wall, wall, wall_pct, cpu_pct, "OK" if ok else "FAIL"))
+    return ok
+
+
+def ceilings(manifest, template_zip, args):
+    # the jobs run at once but share the disk, so the budget covers all of
+    # their work as if run one after another
+    entries = len(manifest) * args.jobs
+    mb = sum(size for size, _ in manifest.values()) * args.jobs / (1 << 20)
+    seconds = max(args.min_seconds, entries * args.seconds_per_entry + mb * args.seconds_per_mb)
+    # writing the zip out touches every page of the embedded template,
+    # nothing else br holds should grow with it
+    rss = os.path.getsize(template_zip) / (1 << 20) + args.rss_slack_mb
+    return seconds, rss
+
+
+def scenario(br, kind, layout, manifest, args, scaffold_dir, max_seconds, rss_ceiling):
+    names = ["%s-%s-%d" % (kind, layout, i) for i in range(args.jobs)]
+    if layout == "shared":
+        dests = [os.path.join(scaffold_dir, kind + "-shared")] * args.jobs
+    else:
+        dests = [os.path.join(scaffold_dir, name + "-dest") for name in names]
+
+    elapsed, rss, _, failures = run_scaffolds(br, "stress_" + kind, dests, names,
+                                           os.path.join(scaffold_dir, "logs"))
+    errors = ["br exited non zero: " + f for f in failures]
+    for i, (dest, name) in enumerate(zip(dests, names)):
+        problem = check_project(os.path.join(dest, name), manifest, full_hash=(i == 0))
+        if problem:
+            errors.append("%s: %s" % (name, problem))
+    for dest in sorted(set(dests)):
+        problem = check_debris(dest, [n for d, n in zip(dests, names) if d == dest])
+        if problem:
+            errors.append("%s: %s" % (dest, problem))
+    if elapsed > max_seconds:
+        errors.append("wall time %.1fs over ceiling %.1fs" % (elapsed, max_seconds))
+    if rss > rss_ceiling:
+        errors.append("peak RSS %.0fMB over ceiling %.0fMB" % (rss, rss_ceiling))
+
+    for dest in sorted(set(dests)):
+        shutil.rmtree(dest, ignore_errors=True)
+    status = "OK" if not errors else "FAIL"
+    print("%-6s %-8s jobs=%-3d %8.2fs (max %.0fs)  peak-rss=%6.0fMB (max %.0fMB)  %s"
+          % (kind, layout, args.jobs, elapsed, max_seconds, rss, rss_ceiling, status))
+    for e in errors[:10]:
+        print("    " + e)
+    return not errors
+
+
+def delta_check(br, manifest, delta_size, zip_size, scaffold_dir):
+    # stress_wide@2 is rebuilt from its delta against stress_wide@1 on extraction
+    dest = os.path.join(scaffold_dir, "wide-delta")
+    name = "wide-delta"
+    elapsed, _, _, failures = run_scaffolds(br, "stress_wide@2", [dest], [name],
+                                            os.path.join(scaffold_dir, "logs"))
+    errors = ["br exited non zero: " + f for f in failures]
+    if not errors:
+        problem = check_project(os.path.join(dest, name), manifest, full_hash=True) or check_debris(dest, [name])
+        if problem:
+            errors.append(problem)
+    shutil.rmtree(dest, ignore_errors=True)
+    print("delta  wide@2   %8.2fs  delta %d of %d bytes  %s"
+          % (elapsed, delta_size, zip_size, "OK" if not errors else "FAIL"))
+    for e in errors:
+        print("    " + e)
+    return not errors
+
+
+def git_check(br, kind, manifest, scaffold_dir):
+    git = shutil.which("git")
+    if git is None:
+        print("git    %-8s git not found, skipped" % kind)
+        return True
+    dest = os.path.join(scaffold_dir, kind + "-git")
+    name = kind + "-git"
+    # --git fails without an identity, as git commit does; pass one that
+    # the commit must carry
+    author = "Stress Author <stress@example.com>"
+    env = dict(os.environ, GIT_AUTHOR_NAME="Stress Author", GIT_AUTHOR_EMAIL="stress@example.com",
+               GIT_COMMITTER_NAME="Stress Committer", GIT_COMMITTER_EMAIL="committer@example.com")
+    elapsed, _, _, failures = run_scaffolds(br, "stress_" + kind, [dest], [name],
+                                            os.path.join(scaffold_dir, "logs"), ["--git"], env)
+    errors = ["br exited non zero: " + f for f in failures]
+    project = os.path.join(dest, name)
+    if not errors:
+        problem = check_project(project, manifest, full_hash=True, skip=(".git",))
+        if problem:
+            errors.append(problem)
+        fsck = subprocess.run([git, "-C", project, "fsck", "--strict"],
+                              stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+        if fsck.returncode != 0:
+            errors.append("git fsck --strict failed: " + fsck.stdout.strip()[-300:])
+        status = subprocess.run([git, "-C", project, "status", "--porcelain"],
+                                stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+        if status.returncode != 0 or status.stdout.strip():
+            errors.append("git status not clean: " + status.stdout.strip()[:300])
+        log = subprocess.run([git, "-C", project, "log", "-1", "--format=%an <%ae>|%cn <%ce>"],
+                             stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+        expected = author + "|Stress Committer <committer@example.com>"
+        if log.returncode != 0 or log.stdout.strip() != expected:
+            errors.append("commit identity %r, expected %r" % (log.stdout.strip(), expected))
+    shutil.rmtree(dest, ignore_errors=True)
+    print("git    %-8s %8.2fs  fsck+status+author  %s" % (kind, elapsed, "OK" if not errors else "FAIL"))
+    for e in errors:
+        print("    " + e)
+    return not errors
+
+
+def sync_costs(br, args, scaffold_dir):
+    variants = {policy: ["--sync", policy] for policy in ("none", "batch", "strict")}
+    ok = True
+    for kind in ("wide", "big"):
+        samples = compare_variants(br, kind, variants, args.bench_rounds, scaffold_dir)
+        if samples is None:
+            print("bench  sync      %-6s scaffold failed  FAIL" % kind)
+            ok = False
+            continue
+        med = medians(samples)
+        base_wall = med["none"][0]
+        print("bench  sync      %-6s " % kind + "  ".join(
+            "%s %.2fs (%+.0f%%)" % (policy, wall, 100 * (wall - base_wall) / base_wall)
+            for policy, (wall, _) in med.items()))
+    return ok
+
+
+def main():
+    args = parse_args()
+    work_dir = args.work_dir or tempfile.mkdtemp(prefix="br-stress-")
+    os.makedirs(work_dir, exist_ok=True)
+    try:
+        template_dir = os.path.join(work_dir, "templates")
+        os.makedirs(template_dir, exist_ok=True)
+        print("[INFO] generating templates in", template_dir)
+        templates, manifests = {}, {}
+        for kind, writer, size in (("wide", write_wide, args.entries),
+                                   ("deep", write_deep, args.depth),
+                                   ("big", write_big, args.big_mb)):
+            zip_path = os.path.join(template_dir, "stress_%s.zip" % kind)
+            manifests[kind] = writer(zip_path, size)
+            templates[kind] = zip_path
+
+        print("[INFO] building br with embedded templates")
+        br = build_br(work_dir, templates, {"wide": "1"})
+        br, delta_manifest, delta_size, delta_zip_size = add_wide_delta(br, work_dir, template_dir,
+                                                                        templates["wide"], args.entries)
+
+        scaffold_dir = os.path.join(work_dir, "scaffolds")
+        ok = True
+        for kind in ("wide", "deep", "big"):
+            max_seconds, rss_ceiling = ceilings(manifests[kind], templates[kind], args)
+            for layout in ("separate", "shared"):
+                ok = scenario(br, kind, layout, manifests[kind], args, scaffold_dir,
+                              max_seconds, rss_ceiling) and ok
+        for kind in ("wide", "big"):
+            ok = git_check(br, kind, manifests[kind], scaffold_dir) and ok
+        ok = delta_check(br, delta_manifest, delta_size, delta_zip_size, scaffold_dir) and ok
+        ok = progress_overhead(br, args, scaffold_dir) and ok
+        ok = sync_costs(br, args, scaffold_dir) and ok
+    finally:
+        if not args.keep:
+            shutil.rmtree(work_dir, ignore_errors=True)
+    print("[SUCCESS] stress run passed" if ok else "[ERROR] stress run failed")
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    if len(sys.argv) > 3 and sys.argv[1] == "--launch":
+        sys.exit(launch(sys.argv[2], sys.argv[4:]))
+    sys.exit(main())
@@ -2,13 +2,30 @@
 
 # Script to convert .zip template files to .h header files
 # This allows the repository to store smaller .zip files instead of large .h files
-# Usage: ./generate_headers.sh [template_name.zip]
+# .delta files (from br -MD) are converted the same way for REGISTER_BUILD_DELTA;
+# a .zip kept next to a .delta of the same name (the target given to br -MD)
+# is skipped, both would otherwise write the same .h
+# Usage: ./generate_headers.sh [template_name.zip|template_name.delta]
 
 set -e
 
 SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
 cd "$SCRIPT_DIR"
 
+# xxd -i declares the length as unsigned int, which wraps at 4 GiB
+MAX_XXD_BYTES=4294967295
+
+check_size() {
+    local size
+    size=$(wc -c < "$1" | tr -d ' ')
+    if [ "$size" -gt "$MAX_XXD_BYTES" ]; then
+        echo "Error: '$1' is $size bytes; xxd -i headers hold at most $MAX_XXD_BYTES"
+        echo "       embed it with .incbin and a 64-bit _zip_len instead"
+        echo "       (see scripts/python/stress/stress_scaffold.py)"
+        return 1
+    fi
+}
+
 echo "=========================================="
 echo "Generating .h files from .zip templates"
 echo "=========================================="
@@ -22,9 +39,15 @@ if [ $# -eq 1 ]; then
         exit 1
     fi
     
-    # Extract base name (without .zip extension)
-    BASE_NAME=$(basename "$ZIP_FILE" .zip)
+    # Extract base name (without .zip or .delta extension)
+    BASE_NAME=$(basename "$(basename "$ZIP_FILE" .zip)" .delta)
     OUTPUT_FILE="${BASE_NAME}.h"
+    if [ "${ZIP_FILE%.zip}" != "$ZIP_FILE" ] && [ -f "${ZIP_FILE%.zip}.delta" ]; then
+        echo "Error: '${ZIP_FILE%.zip}.delta' also converts to $OUTPUT_FILE"
+        echo "       rename one of them, or convert the .delta for REGISTER_BUILD_DELTA"
+        exit 1
+    fi
+    check_size "$ZIP_FILE" || exit 1
     
     echo "Converting: $ZIP_FILE -> $OUTPUT_FILE"
     xxd -i "$ZIP_FILE" > "$OUTPUT_FILE"
@@ -33,7 +56,7 @@ if [ $# -eq 1 ]; then
 fi
 
 # Otherwise, process all .zip files in the directory
-ZIP_COUNT=$(find . -maxdepth 1 -name "*.zip" | wc -l | tr -d ' ')
+ZIP_COUNT=$(find . -maxdepth 1 \( -name "*.zip" -o -name "*.delta" \) | wc -l | tr -d ' ')
 
 if [ "$ZIP_COUNT" -eq 0 ]; then
     echo "No .zip files found in templates directory"
@@ -46,13 +69,22 @@ if [ "$ZIP_COUNT" -eq 0 ]; then
     exit 0
 fi
 
-echo "Found $ZIP_COUNT .zip file(s)"
+echo "Found $ZIP_COUNT .zip/.delta file(s)"
 echo ""
 
-for zip_file in *.zip; do
+for zip_file in *.zip *.delta; do
     if [ -f "$zip_file" ]; then
-        BASE_NAME=$(basename "$zip_file" .zip)
+        BASE_NAME=$(basename "$(basename "$zip_file" .zip)" .delta)
         OUTPUT_FILE="${BASE_NAME}.h"
+        if [ "${zip_file%.zip}" != "$zip_file" ] && [ -f "${BASE_NAME}.delta" ]; then
+            echo "Skipping: $zip_file (${BASE_NAME}.delta is embedded as $OUTPUT_FILE instead)"
+            echo ""
+            continue
+        fi
+        if ! check_size "$zip_file"; then
+            echo ""
+            continue
+        fi
         
         echo "Converting: $zip_file -> $OUTPUT_FILE"
         xxd -i "$zip_file" > "$OUTPUT_FILE"